@@ -0,0 +1,173 @@
+#include "AnimationBenchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double microsecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+}
+
+AnimationBenchmark::Report AnimationBenchmark::run(std::function<Timeline()> const& build, int iterations, Scene* scene) {
+    Report report = {};
+    iterations = std::max(iterations, 1);
+
+    Timeline timeline;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        timeline = build();
+    }
+    report.buildMicroseconds = microsecondsSince(start) / iterations;
+
+    report.fragments = timeline.getFragments().size();
+    report.nodes = report.fragments + timeline.getLayers().size() + timeline.getBursts().size();
+    for (auto const& burst : timeline.getBursts()) {
+        report.particles += burst.size();
+    }
+    report.keys = timeline.getKeyCount();
+    report.memoryBytes = timeline.getMemoryUsage();
+    report.duration = timeline.getDuration();
+
+    for (size_t rate = 0; rate < std::size(kRefreshRates); rate++) {
+        report.frames[rate] = simulate(timeline, kRefreshRates[rate], report.peakLiveNodes, scene);
+    }
+    return report;
+}
+
+// Same loop as AnimationRunner::update; without a scene, minus the node setters and the burst quads
+AnimationBenchmark::FrameCost AnimationBenchmark::simulate(Timeline const& timeline, int refreshRate, size_t& peakLive, Scene* scene) {
+    FrameCost cost = { refreshRate, 0, 0.0, 0.0, 0.0, 0 };
+    auto const& fragments = timeline.getFragments();
+    std::vector<uint32_t> cursors(fragments.size() * Timeline::ChannelCount, 0);
+    std::vector<bool> shown(scene ? fragments.size() : 0, false);
+    auto bursts = timeline.getBursts();
+    if (scene) {
+        scene->load(timeline);
+    }
+
+    float dt = 1.0f / refreshRate;
+    volatile float sink = 0.0f;
+    double total = 0.0;
+
+    for (float time = 0.0f; time < timeline.getDuration() + dt; time += dt) {
+        auto start = Clock::now();
+        size_t live = 0;
+        float frameSum = 0.0f;
+        for (size_t fragment = 0; fragment < fragments.size(); fragment++) {
+            if (time < fragments[fragment].start) continue;
+            if (time >= fragments[fragment].end) {
+                if (scene && shown[fragment]) {
+                    scene->retire(fragment);
+                    shown[fragment] = false;
+                }
+                continue;
+            }
+            live++;
+            float values[Timeline::ChannelCount];
+            for (int channel = 0; channel < Timeline::ChannelCount; channel++) {
+                if (timeline.isAnimated(fragment, static_cast<Timeline::Channel>(channel))) {
+                    values[channel] = timeline.evaluate(
+                        fragment, static_cast<Timeline::Channel>(channel), time,
+                        cursors[fragment * Timeline::ChannelCount + channel]
+                    );
+                    frameSum += values[channel];
+                }
+            }
+            if (scene) {
+                scene->apply(fragment, values);
+                shown[fragment] = true;
+            }
+        }
+        for (size_t burst = 0; burst < bursts.size(); burst++) {
+            frameSum += static_cast<float>(bursts[burst].step(time));
+            if (scene) {
+                scene->advance(burst, bursts[burst]);
+            }
+        }
+        if (scene) {
+            cost.peakDrawn = std::max(cost.peakDrawn, scene->draw());
+        }
+        sink = sink + frameSum;
+
+        double elapsed = microsecondsSince(start);
+        total += elapsed;
+        cost.worstMicroseconds = std::max(cost.worstMicroseconds, elapsed);
+        cost.frames++;
+        peakLive = std::max(peakLive, live);
+    }
+
+    cost.averageMicroseconds = cost.frames ? total / cost.frames : 0.0;
+    cost.budgetPercent = cost.worstMicroseconds / (1000000.0 / refreshRate) * 100.0;
+    return cost;
+}
+
+AnimationBenchmark::FlipbookCost AnimationBenchmark::compareFlipbook(Timeline const& timeline, Flipbook::Stamp const& stamp, Flipbook::Settings const& settings) {
+    FlipbookCost cost = {};
+    auto start = Clock::now();
+    auto flipbook = Flipbook::bake(timeline, Quality::High, stamp, settings);
+    cost.bakeMilliseconds = microsecondsSince(start) / 1000.0;
+    cost.frames = flipbook.getFrameCount();
+    cost.frameWidth = flipbook.getFrameWidth();
+    cost.frameHeight = flipbook.getFrameHeight();
+    cost.textureBytes = flipbook.getMemoryUsage();
+    cost.diskBytes = flipbook.getEncodedSize();
+
+    size_t peakLive = 0;
+    cost.liveMicroseconds = simulate(timeline, kRefreshRates[0], peakLive).averageMicroseconds;
+
+    Timeline rest = timeline;
+    Flipbook::removeCovered(rest);
+    cost.liveFragments = rest.getFragments().size();
+    auto frames = simulate(rest, kRefreshRates[0], peakLive);
+
+    // Picking the frame is all the flipbook itself does per frame
+    volatile uint32_t sink = 0;
+    start = Clock::now();
+    for (size_t frame = 0; frame < frames.frames; frame++) {
+        sink = sink + flipbook.frameAt(static_cast<float>(frame) / std::max<size_t>(frames.frames - 1, 1));
+    }
+    double picking = frames.frames ? microsecondsSince(start) / frames.frames : 0.0;
+    cost.flipbookMicroseconds = frames.averageMicroseconds + picking;
+    return cost;
+}
+
+AnimationBenchmark::GhostCost AnimationBenchmark::recordGhost(int refreshRate) {
+    GhostCost cost = { refreshRate, 0, 0.0, 0.0, 0, 0.0f, 0.0f };
+    GhostRecorder recorder;
+    std::vector<GhostSample> recorded;
+    recorded.reserve(static_cast<size_t>(60 * refreshRate) + 1);
+
+    // Normal speed with a jump every half second and a mode change every ten
+    float dt = 1.0f / refreshRate;
+    float time = 0.0f;
+    auto start = Clock::now();
+    for (size_t frame = 0; frame < static_cast<size_t>(60 * refreshRate); frame++) {
+        time += dt;
+        float x = time * 311.58f;
+        float y = 105.0f + std::abs(std::sin(time * 6.2832f)) * 60.0f;
+        float rotation = std::fmod(time * 415.0f, 360.0f);
+        auto mode = static_cast<GhostMode>(static_cast<int>(time / 10.0f) % 8);
+        recorder.record(dt, x, y, rotation, mode, false);
+        recorded.push_back({ time, x, y, rotation, mode, false });
+    }
+    cost.frames = recorded.size();
+    // Timed together with the copy above, so this is an upper bound
+    cost.recordNanoseconds = microsecondsSince(start) * 1000.0 / cost.frames;
+
+    start = Clock::now();
+    auto samples = recorder.extract(10.0f);
+    cost.extractMicroseconds = microsecondsSince(start);
+
+    size_t offset = recorded.size() - samples.size();
+    for (size_t i = 0; i < samples.size(); i++) {
+        auto const& real = recorded[offset + i];
+        cost.worstError = std::max({ cost.worstError, std::abs(samples[i].x - real.x), std::abs(samples[i].y - real.y) });
+    }
+
+    cost.bytesPerMinute = cost.frames * GhostRecorder::getMemoryUsage() / GhostRecorder::kCapacity;
+    cost.ringSeconds = static_cast<float>(GhostRecorder::kCapacity) / refreshRate;
+    return cost;
+}
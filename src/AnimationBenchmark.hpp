@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include "Flipbook.hpp"
+#include "GhostRecorder.hpp"
+#include "Timeline.hpp"
+
+// Measures what an animation costs without touching cocos2d: how long building its timeline
+// takes, how big the result is, and how long the runner's per-frame evaluation of every live
+// fragment takes when stepped at common refresh rates. A Scene passed in adds the node work.
+class AnimationBenchmark {
+public:
+    struct FrameCost {
+        int refreshRate;
+        size_t frames;
+        double averageMicroseconds;
+        double worstMicroseconds;
+        double budgetPercent;   // worst frame as a share of the frame budget at this refresh rate
+        size_t peakDrawn;       // most quads the scene drew in one frame, 0 without a scene
+    };
+
+    // Stands in for the nodes AnimationRunner drives, so whoever has some can time their setters
+    // and draws along with the timeline. The tools pass a stub scene graph, the mod none
+    class Scene {
+    public:
+        virtual ~Scene() = default;
+
+        // Before the first frame of every run; may allocate, nothing after it should
+        virtual void load(Timeline const& timeline) = 0;
+        // A live fragment's values by Timeline::Channel, only its animated channels are set
+        virtual void apply(size_t fragment, float const* values) = 0;
+        virtual void retire(size_t fragment) = 0;
+        // After the burst was stepped to this frame
+        virtual void advance(size_t burst, ParticleBurst const& particles) = 0;
+        // Ends the frame, returns the quads it drew
+        virtual size_t draw() = 0;
+    };
+
+    struct Report {
+        double buildMicroseconds;   // average over all iterations
+        size_t fragments;
+        size_t particles;           // in bursts, which are one node each
+        size_t nodes;               // sprites, overlays and batches the animation puts in the scene
+        size_t peakLiveNodes;       // most fragments alive at once, what the pool has to hold
+        size_t keys;
+        size_t memoryBytes;
+        float duration;
+        FrameCost frames[3];
+    };
+
+    // A minute of a synthetic run recorded for the ghost replay at one refresh rate
+    struct GhostCost {
+        int refreshRate;
+        size_t frames;
+        double recordNanoseconds;   // average per frame
+        double extractMicroseconds; // decoding the last ten seconds
+        size_t bytesPerMinute;      // what the ring fills per minute, keys included
+        float ringSeconds;          // how much gameplay the ring holds at this rate
+        float worstError;           // largest decoded position error, in units
+    };
+
+    // The same animation played live and from a flipbook, per frame at 60 Hz. As in simulate()
+    // without a scene, only the timeline evaluation is timed: node updates and draws are in neither
+    struct FlipbookCost {
+        double bakeMilliseconds;
+        uint32_t frames;
+        uint32_t frameWidth;
+        uint32_t frameHeight;
+        size_t textureBytes;
+        size_t diskBytes;
+        size_t liveFragments;           // left for the runner next to the flipbook
+        double liveMicroseconds;
+        double flipbookMicroseconds;    // the fragments left, plus picking the frame
+    };
+
+    static constexpr int kRefreshRates[3] = { 60, 144, 240 };
+
+    static Report run(std::function<Timeline()> const& build, int iterations, Scene* scene = nullptr);
+    static GhostCost recordGhost(int refreshRate);
+    static FlipbookCost compareFlipbook(Timeline const& timeline, Flipbook::Stamp const& stamp, Flipbook::Settings const& settings);
+
+private:
+    static FrameCost simulate(Timeline const& timeline, int refreshRate, size_t& peakLive, Scene* scene = nullptr);
+};
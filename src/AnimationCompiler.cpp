@@ -0,0 +1,435 @@
+#include <Geode/Geode.hpp>
+#include "AnimationCompiler.hpp"
+
+using namespace geode::prelude;
+
+namespace {
+    PackedValue constant(float value) {
+        return { value, 0.0f, 0.0f, 0, 0, kNoVariable, 0 };
+    }
+
+    PackedPosition origin() {
+        return { constant(0.0f), constant(0.0f), constant(0.0f), constant(0.0f) };
+    }
+
+    PackedStep emptyStep(PackedStep::Op op) {
+        PackedStep step = {};
+        step.op = op;
+        step.ease = Ease::Linear;
+        step.rate = 1.0f;
+        step.duration = constant(0.0f);
+        step.position = origin();
+        step.value = constant(0.0f);
+        for (auto& channel : step.color) {
+            channel = constant(0.0f);
+        }
+        return step;
+    }
+
+    float number(matjson::Value const& json, float fallback) {
+        return json.isNumber() ? static_cast<float>(json.asDouble().unwrapOr(fallback)) : fallback;
+    }
+
+    Result<Ease> parseEase(matjson::Value const& json) {
+        if (json.isNull()) return Ok(Ease::Linear);
+
+        auto name = json.asString().unwrapOr("");
+        if (name == "linear") return Ok(Ease::Linear);
+        if (name == "in") return Ok(Ease::In);
+        if (name == "out") return Ok(Ease::Out);
+        if (name == "inOut") return Ok(Ease::InOut);
+        return Err(fmt::format("unknown ease '{}'", name));
+    }
+
+    // Steps are objects keyed by their operation, the rest of the keys are its arguments
+    constexpr std::pair<const char*, PackedStep::Op> kStepOps[] = {
+        { "wait", PackedStep::Op::Wait },
+        { "after", PackedStep::Op::After },
+        { "moveTo", PackedStep::Op::MoveTo },
+        { "moveBy", PackedStep::Op::MoveBy },
+        { "jumpTo", PackedStep::Op::JumpTo },
+        { "scaleTo", PackedStep::Op::ScaleTo },
+        { "rotateBy", PackedStep::Op::RotateBy },
+        { "tintTo", PackedStep::Op::TintTo },
+        { "fadeTo", PackedStep::Op::FadeTo },
+        { "fadeIn", PackedStep::Op::FadeTo },
+        { "fadeOut", PackedStep::Op::FadeTo },
+        { "repeat", PackedStep::Op::Repeat }
+    };
+}
+
+// ===============================================================================================
+// DEFINITIONS
+
+Result<> AnimationCompiler::add(std::string const& name, std::string const& json) {
+    if (name.empty() || name.size() >= kAnimationNameLength) {
+        return Err(fmt::format("name must be 1 to {} characters", kAnimationNameLength - 1));
+    }
+    for (auto const& animation : m_animations) {
+        if (name == animation.name) return Err("an animation with this name already exists");
+    }
+
+    auto root = matjson::parse(json);
+    if (!root) return Err(fmt::format("invalid JSON: {}", root.unwrapErr().message));
+
+    // Roll back everything this file added if any part of it is invalid
+    size_t layers = m_layers.size();
+    size_t emitters = m_emitters.size();
+    size_t steps = m_steps.size();
+    size_t variables = m_variables.size();
+    size_t tables = m_tables.size();
+    size_t bursts = m_bursts.size();
+
+    PackedAnimation animation = {};
+    std::copy(name.begin(), name.end(), animation.name);
+    auto result = parseAnimation(animation, root.unwrap());
+    if (!result) {
+        m_layers.resize(layers);
+        m_emitters.resize(emitters);
+        m_steps.resize(steps);
+        m_variables.resize(variables);
+        m_tables.resize(tables);
+        m_bursts.resize(bursts);
+        return result;
+    }
+
+    m_animations.push_back(animation);
+    return Ok();
+}
+
+Result<> AnimationCompiler::parseAnimation(PackedAnimation& animation, matjson::Value const& root) {
+    if (!root.isObject()) return Err("the root must be an object");
+    if (!root["layers"].isArray() || root["layers"].size() == 0 || root["layers"].size() > 0xFF) {
+        return Err("'layers' must list 1 to 255 Z-orders");
+    }
+    if (!root["emitters"].isArray()) return Err("'emitters' must be an array");
+
+    animation.firstLayer = static_cast<uint32_t>(m_layers.size());
+    for (auto const& layer : root["layers"]) {
+        m_layers.push_back(static_cast<int32_t>(number(layer, 0.0f)));
+    }
+    animation.layerCount = static_cast<uint32_t>(m_layers.size()) - animation.firstLayer;
+
+    // Emitters are parsed into a local list first, since each one appends its own steps
+    std::vector<PackedEmitter> emitters;
+    for (auto const& json : root["emitters"]) {
+        PackedEmitter emitter = {};
+        GEODE_UNWRAP(parseEmitter(emitter, json, animation.layerCount));
+        emitters.push_back(emitter);
+    }
+
+    animation.firstEmitter = static_cast<uint32_t>(m_emitters.size());
+    animation.emitterCount = static_cast<uint32_t>(emitters.size());
+    m_emitters.insert(m_emitters.end(), emitters.begin(), emitters.end());
+    return Ok();
+}
+
+Result<> AnimationCompiler::parseEmitter(PackedEmitter& emitter, matjson::Value const& json, uint32_t layerCount) {
+    if (!json.isObject()) return Err("every emitter must be an object");
+
+    auto shape = json["shape"].asString().unwrapOr("fragment");
+    if (shape == "fragment") {
+        emitter.shape = PackedEmitter::Shape::Fragment;
+    } else if (shape == "player") {
+        emitter.shape = PackedEmitter::Shape::Player;
+    } else if (shape == "overlay") {
+        emitter.shape = PackedEmitter::Shape::Overlay;
+    } else if (shape == "column") {
+        emitter.shape = PackedEmitter::Shape::Column;
+    } else if (shape == "burst") {
+        emitter.shape = PackedEmitter::Shape::Burst;
+    } else if (shape == "tint") {
+        emitter.shape = PackedEmitter::Shape::Tint;
+    } else if (shape == "flash") {
+        emitter.shape = PackedEmitter::Shape::Flash;
+    } else if (shape == "vignette") {
+        emitter.shape = PackedEmitter::Shape::Vignette;
+    } else if (shape == "shockwave") {
+        emitter.shape = PackedEmitter::Shape::Shockwave;
+    } else if (shape == "zoom") {
+        emitter.shape = PackedEmitter::Shape::Zoom;
+    } else {
+        return Err(fmt::format("unknown shape '{}'", shape));
+    }
+
+    auto detail = json["detail"].asString().unwrapOr("low");
+    if (detail == "low") {
+        emitter.detail = Quality::Low;
+    } else if (detail == "medium") {
+        emitter.detail = Quality::Medium;
+    } else if (detail == "high") {
+        emitter.detail = Quality::High;
+    } else {
+        return Err(fmt::format("unknown detail '{}'", detail));
+    }
+
+    float count = number(json["count"], 1.0f);
+    if (count < 1.0f || count > 10000.0f) return Err("'count' must be between 1 and 10000");
+    emitter.count = static_cast<uint32_t>(count);
+
+    float layer = number(json["layer"], 0.0f);
+    if (layer < 0.0f || layer >= layerCount) return Err(fmt::format("layer {} does not exist", layer));
+    emitter.layer = static_cast<uint8_t>(layer);
+
+    // Variables are rolled once per fragment, so several steps can share e.g. one random direction
+    Variables variables;
+    emitter.firstVariable = static_cast<uint32_t>(m_variables.size());
+    if (json.contains("vars")) {
+        if (!json["vars"].isObject()) return Err("'vars' must be an object");
+        for (auto const& variable : json["vars"]) {
+            if (variables.size() == kMaxVariables) return Err(fmt::format("at most {} variables per emitter", kMaxVariables));
+            GEODE_UNWRAP_INTO(auto value, parseValue(variable, variables));
+            m_variables.push_back(value);
+            variables.push_back(variable.getKey().value_or(""));
+        }
+    }
+    emitter.variableCount = static_cast<uint8_t>(variables.size());
+
+    emitter.zOrder = constant(0.0f);
+    emitter.position = origin();
+    emitter.scale = constant(1.0f);
+    emitter.width = constant(1.0f);
+    emitter.rotation = constant(0.0f);
+    emitter.opacity = constant(255.0f);
+    for (auto& channel : emitter.color) {
+        channel = constant(255.0f);
+    }
+
+    if (json.contains("z")) {
+        GEODE_UNWRAP_INTO(emitter.zOrder, parseValue(json["z"], variables));
+    }
+    if (json.contains("position")) {
+        GEODE_UNWRAP_INTO(emitter.position, parsePosition(json["position"], variables));
+    }
+    if (json.contains("scale")) {
+        GEODE_UNWRAP_INTO(emitter.scale, parseValue(json["scale"], variables));
+    }
+    if (json.contains("width")) {
+        GEODE_UNWRAP_INTO(emitter.width, parseValue(json["width"], variables));
+    }
+    if (json.contains("rotation")) {
+        GEODE_UNWRAP_INTO(emitter.rotation, parseValue(json["rotation"], variables));
+    }
+    if (json.contains("opacity")) {
+        GEODE_UNWRAP_INTO(emitter.opacity, parseValue(json["opacity"], variables));
+    }
+    if (json.contains("color")) {
+        GEODE_UNWRAP(parseColor(emitter.color, json["color"], variables));
+    }
+
+    emitter.firstStep = static_cast<uint32_t>(m_steps.size());
+    if (emitter.shape == PackedEmitter::Shape::Burst) {
+        if (json.contains("steps")) return Err("a burst moves its particles with its own keys, not 'steps'");
+        GEODE_UNWRAP(parseBurst(emitter, json, variables));
+    } else if (json.contains("steps")) {
+        GEODE_UNWRAP(parseSteps(json["steps"], variables));
+    }
+    emitter.stepCount = static_cast<uint32_t>(m_steps.size()) - emitter.firstStep;
+    return Ok();
+}
+
+Result<> AnimationCompiler::parseBurst(PackedEmitter& emitter, matjson::Value const& json, Variables const& variables) {
+    PackedBurst burst = {};
+    GEODE_UNWRAP_INTO(burst.ease, parseEase(json["ease"]));
+    burst.rate = number(json["rate"], 1.0f);
+    burst.delay = constant(0.0f);
+    burst.life = constant(1.0f);
+    burst.to = origin();
+    burst.height = constant(0.0f);
+    burst.spin = constant(0.0f);
+    burst.peakScale = constant(1.0f);
+    burst.peakTime = constant(0.0f);
+    burst.endScale = constant(1.0f);
+    burst.fade = constant(0.0f);
+
+    std::pair<const char*, PackedValue*> values[] = {
+        { "delay", &burst.delay }, { "life", &burst.life }, { "height", &burst.height }, { "spin", &burst.spin },
+        { "peakScale", &burst.peakScale }, { "peakTime", &burst.peakTime }, { "endScale", &burst.endScale },
+        { "fade", &burst.fade }
+    };
+    for (auto [key, value] : values) {
+        if (json.contains(key)) {
+            GEODE_UNWRAP_INTO(*value, parseValue(json[key], variables));
+        }
+    }
+    if (json.contains("to")) {
+        GEODE_UNWRAP_INTO(burst.to, parsePosition(json["to"], variables));
+    }
+    if (json.contains("peakScale") != json.contains("peakTime")) return Err("'peakScale' and 'peakTime' go together");
+    if (json.contains("peakScale")) {
+        burst.flags |= PackedBurst::HasPeak;
+    }
+    if (json.contains("endScale")) {
+        burst.flags |= PackedBurst::HasEndScale;
+    }
+
+    emitter.burst = static_cast<uint32_t>(m_bursts.size());
+    m_bursts.push_back(burst);
+    return Ok();
+}
+
+// ===============================================================================================
+// STEPS AND VALUES
+
+Result<> AnimationCompiler::parseSteps(matjson::Value const& json, Variables const& variables) {
+    if (!json.isArray()) return Err("'steps' must be an array");
+
+    for (auto const& item : json) {
+        if (item.isString() && item.asString().unwrapOr("") == "remove") {
+            m_steps.push_back(emptyStep(PackedStep::Op::Remove));
+            continue;
+        }
+        if (!item.isObject()) return Err("every step must be an object or \"remove\"");
+
+        auto op = std::find_if(std::begin(kStepOps), std::end(kStepOps), [&](auto const& entry) {
+            return item.contains(entry.first);
+        });
+        if (op == std::end(kStepOps)) return Err(fmt::format("unknown step {}", item.dump(0)));
+
+        std::string key = op->first;
+        auto const& argument = item[key];
+        auto step = emptyStep(op->second);
+
+        if (op->second == PackedStep::Op::Repeat) {
+            float count = number(argument, 0.0f);
+            if (count < 0.0f || count > kMaxRepeat) return Err(fmt::format("'repeat' must be between 0 and {}", kMaxRepeat));
+            step.count = static_cast<uint32_t>(count);
+
+            size_t index = m_steps.size();
+            m_steps.push_back(step);
+            GEODE_UNWRAP(parseSteps(item["steps"], variables));
+            m_steps[index].body = static_cast<uint32_t>(m_steps.size() - index - 1);
+            continue;
+        }
+
+        GEODE_UNWRAP_INTO(step.ease, parseEase(item["ease"]));
+        step.rate = number(item["rate"], 1.0f);
+        if (item.contains("duration")) {
+            GEODE_UNWRAP_INTO(step.duration, parseValue(item["duration"], variables));
+        }
+
+        if (key == "wait" || key == "after") {
+            GEODE_UNWRAP_INTO(step.duration, parseValue(argument, variables));
+        } else if (key == "fadeIn" || key == "fadeOut") {
+            GEODE_UNWRAP_INTO(step.duration, parseValue(argument, variables));
+            step.value = constant(key == "fadeIn" ? 255.0f : 0.0f);
+        } else if (key == "moveTo" || key == "moveBy" || key == "jumpTo") {
+            GEODE_UNWRAP_INTO(step.position, parsePosition(argument, variables));
+            if (key == "jumpTo") {
+                GEODE_UNWRAP_INTO(step.value, parseValue(item["height"], variables));
+            }
+        } else if (key == "tintTo") {
+            GEODE_UNWRAP(parseColor(step.color, argument, variables));
+        } else {
+            GEODE_UNWRAP_INTO(step.value, parseValue(argument, variables));
+        }
+        m_steps.push_back(step);
+    }
+    return Ok();
+}
+
+Result<PackedValue> AnimationCompiler::parseValue(matjson::Value const& json, Variables const& variables) {
+    if (json.isNumber()) return Ok(constant(number(json, 0.0f)));
+    if (!json.isObject()) return Err(fmt::format("expected a number or a value object, got {}", json.dump(0)));
+
+    auto value = constant(number(json["base"], 0.0f));
+    value.step = number(json["step"], 0.0f);
+    value.random = number(json["random"], 0.0f);
+    if (json["sign"].asBool().unwrapOr(false)) {
+        value.flags |= PackedValue::RandomSign;
+    }
+
+    if (json.contains("var")) {
+        auto name = json["var"].asString().unwrapOr("");
+        auto variable = std::find(variables.begin(), variables.end(), name);
+        if (variable == variables.end()) return Err(fmt::format("unknown variable '{}'", name));
+        value.variable = static_cast<uint8_t>(variable - variables.begin());
+    }
+
+    if (json.contains("table")) {
+        auto const& table = json["table"];
+        if (!table.isArray() || table.size() == 0 || table.size() > 0xFFFF) return Err("'table' must list 1 to 65535 numbers");
+        value.table = static_cast<uint32_t>(m_tables.size());
+        value.tableSize = static_cast<uint16_t>(table.size());
+        for (auto const& entry : table) {
+            m_tables.push_back(number(entry, 0.0f));
+        }
+    }
+    return Ok(value);
+}
+
+Result<PackedPosition> AnimationCompiler::parsePosition(matjson::Value const& json, Variables const& variables) {
+    auto position = origin();
+
+    if (json.isArray()) {
+        if (json.size() != 2) return Err("a position array must be [x, y]");
+        GEODE_UNWRAP_INTO(position.x, parseValue(json[0], variables));
+        GEODE_UNWRAP_INTO(position.y, parseValue(json[1], variables));
+        return Ok(position);
+    }
+    if (!json.isObject()) return Err("a position must be [x, y] or an object");
+
+    if (json.contains("x")) {
+        GEODE_UNWRAP_INTO(position.x, parseValue(json["x"], variables));
+    }
+    if (json.contains("y")) {
+        GEODE_UNWRAP_INTO(position.y, parseValue(json["y"], variables));
+    }
+    if (json.contains("angle")) {
+        GEODE_UNWRAP_INTO(position.angle, parseValue(json["angle"], variables));
+    }
+    if (json.contains("distance")) {
+        GEODE_UNWRAP_INTO(position.distance, parseValue(json["distance"], variables));
+    }
+    return Ok(position);
+}
+
+Result<> AnimationCompiler::parseColor(PackedValue (&color)[3], matjson::Value const& json, Variables const& variables) {
+    if (!json.isArray() || json.size() != 3) return Err("a color must be [r, g, b]");
+
+    for (size_t channel = 0; channel < 3; channel++) {
+        GEODE_UNWRAP_INTO(color[channel], parseValue(json[channel], variables));
+    }
+    return Ok();
+}
+
+// ===============================================================================================
+// OUTPUT
+
+std::vector<uint8_t> AnimationCompiler::finish(uint64_t fingerprint) const {
+    PackedHeader header = {};
+    header.magic = kAnimationPackMagic;
+    header.version = kAnimationPackVersion;
+    header.fingerprint = fingerprint;
+
+    // Every record size is a multiple of 4, so the sections stay aligned back to back
+    uint32_t offset = sizeof(PackedHeader);
+    auto place = [&](PackedSection& section, auto const& records) {
+        section.offset = offset;
+        section.count = static_cast<uint32_t>(records.size());
+        offset += static_cast<uint32_t>(records.size() * sizeof(records[0]));
+    };
+    place(header.animations, m_animations);
+    place(header.layers, m_layers);
+    place(header.emitters, m_emitters);
+    place(header.steps, m_steps);
+    place(header.variables, m_variables);
+    place(header.tables, m_tables);
+    place(header.bursts, m_bursts);
+
+    std::vector<uint8_t> data(offset);
+    std::memcpy(data.data(), &header, sizeof(header));
+    auto copy = [&](PackedSection const& section, auto const& records) {
+        if (!records.empty()) {
+            std::memcpy(data.data() + section.offset, records.data(), records.size() * sizeof(records[0]));
+        }
+    };
+    copy(header.animations, m_animations);
+    copy(header.layers, m_layers);
+    copy(header.emitters, m_emitters);
+    copy(header.steps, m_steps);
+    copy(header.variables, m_variables);
+    copy(header.tables, m_tables);
+    copy(header.bursts, m_bursts);
+    return data;
+}
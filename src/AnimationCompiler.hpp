@@ -0,0 +1,34 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "AnimationPack.hpp"
+
+using namespace geode::prelude;
+
+// Compiles JSON animation definitions into the binary layout read by AnimationPack.
+// Definitions are added one file at a time; a file that fails to compile leaves nothing behind.
+class AnimationCompiler {
+public:
+    Result<> add(std::string const& name, std::string const& json);
+    std::vector<uint8_t> finish(uint64_t fingerprint) const;
+
+    size_t getAnimationCount() const { return m_animations.size(); }
+
+private:
+    using Variables = std::vector<std::string>;
+
+    Result<> parseAnimation(PackedAnimation& animation, matjson::Value const& root);
+    Result<> parseEmitter(PackedEmitter& emitter, matjson::Value const& json, uint32_t layerCount);
+    Result<> parseBurst(PackedEmitter& emitter, matjson::Value const& json, Variables const& variables);
+    Result<> parseSteps(matjson::Value const& json, Variables const& variables);
+    Result<PackedValue> parseValue(matjson::Value const& json, Variables const& variables);
+    Result<PackedPosition> parsePosition(matjson::Value const& json, Variables const& variables);
+    Result<> parseColor(PackedValue (&color)[3], matjson::Value const& json, Variables const& variables);
+
+    std::vector<PackedAnimation> m_animations;
+    std::vector<int32_t> m_layers;
+    std::vector<PackedEmitter> m_emitters;
+    std::vector<PackedStep> m_steps;
+    std::vector<PackedValue> m_variables;
+    std::vector<float> m_tables;
+    std::vector<PackedBurst> m_bursts;
+};
@@ -0,0 +1,55 @@
+#include <Geode/Geode.hpp>
+#include "AnimationLayer.hpp"
+#include "AnimationRunner.hpp"
+#include "Trace.hpp"
+
+using namespace geode::prelude;
+
+AnimationLayer* AnimationLayer::create(PlayLayer* playLayer) {
+    auto ret = new AnimationLayer();
+    if (ret->init(playLayer)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool AnimationLayer::init(PlayLayer* playLayer) {
+    if (!CCNode::init()) return false;
+
+    m_playLayer = playLayer;
+    this->setID("death-animations"_spr);
+    playLayer->addChild(this, kZOrder);
+    m_postProcess = PostProcess::create(playLayer);
+    return true;
+}
+
+CCPoint AnimationLayer::toLayerSpace(CCPoint objectPosition) {
+    return this->convertToNodeSpace(m_playLayer->m_objectLayer->convertToWorldSpace(objectPosition));
+}
+
+void AnimationLayer::clear() {
+    // A reset halfway through an effect must not leave the level hidden behind it
+    m_postProcess->clear();
+    m_postProcess->commit();
+
+    auto children = this->getChildren();
+    if (!children || children->count() == 0) return;
+
+    // Runners go first so their pooled fragments and batches are reclaimed, not destroyed.
+    // Cancelling removes the runner, so collect them before touching the child list
+    std::vector<AnimationRunner*> runners;
+    for (auto child : CCArrayExt<CCNode*>(children)) {
+        if (auto runner = typeinfo_cast<AnimationRunner*>(child)) {
+            runners.push_back(runner);
+        }
+    }
+    for (auto runner : runners) {
+        runner->cancel();
+    }
+
+    // Whatever is left (overlays, stats) goes in a single pass, actions and schedules included
+    this->removeAllChildrenWithCleanup(true);
+    Trace::instant(TraceEvent::Clear, 0.0f, 0.0f, static_cast<int32_t>(runners.size()));
+}
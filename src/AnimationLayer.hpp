@@ -0,0 +1,36 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "FragmentPool.hpp"
+#include "PostProcess.hpp"
+
+using namespace geode::prelude;
+
+class AnimationRunner;
+
+// The one node every death animation lives under: fragment batches, overlays, runners and the
+// performance overlay, plus the post-process pass for their full-screen effects. Created with
+// the PlayLayer and kept for its whole life, so a reset or level exit tears every animation down
+// from one place instead of waiting for each to finish.
+class AnimationLayer : public CCNode {
+public:
+    // Above the level and its UI; animations order their own nodes inside it
+    static constexpr int kZOrder = 1000;
+
+    static AnimationLayer* create(PlayLayer* playLayer);
+
+    // Cancels every running animation, hands its fragments back to the pool and drops the rest
+    void clear();
+
+    // A position in the level's object layer, where the players die, as seen from this layer
+    CCPoint toLayerSpace(CCPoint objectPosition);
+
+    FragmentPool& getPool() { return m_pool; }
+    PostProcess* getPostProcess() { return m_postProcess; }
+
+private:
+    bool init(PlayLayer* playLayer);
+
+    PlayLayer* m_playLayer = nullptr;
+    FragmentPool m_pool;
+    Ref<PostProcess> m_postProcess;     // in the scene rather than under us, see PostProcess
+};
@@ -0,0 +1,392 @@
+#include "AnimationPack.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr float kDegreesToRadians = 3.14159265f / 180.0f;
+
+    uint8_t toByte(float value) {
+        return static_cast<uint8_t>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+    }
+
+    bool fits(PackedSection const& section, size_t elementSize, size_t size) {
+        return section.offset % 4 == 0
+            && section.offset <= size
+            && section.count <= (size - section.offset) / elementSize;
+    }
+
+    bool inRange(uint32_t first, uint32_t count, uint32_t total) {
+        return first <= total && count <= total - first;
+    }
+
+    // Spreads an emitter's fragments over the tiers (3 in 10 on low, 6 in 10 on medium),
+    // interleaved so lower tiers thin out every part of the emitter evenly
+    Quality detailFor(PackedEmitter const& emitter, uint32_t index) {
+        if (emitter.count == 1) return emitter.detail;
+
+        uint32_t rank = (index * 7) % 10;
+        Quality detail = rank < 3 ? Quality::Low : rank < 6 ? Quality::Medium : Quality::High;
+        return std::max(detail, emitter.detail);
+    }
+}
+
+// ===============================================================================================
+// VALIDATION
+
+bool AnimationPack::attach(const uint8_t* data, size_t size) {
+    detach();
+    if (!data || size < sizeof(PackedHeader)) return false;
+
+    auto header = reinterpret_cast<const PackedHeader*>(data);
+    if (header->magic != kAnimationPackMagic || header->version != kAnimationPackVersion) return false;
+    if (!fits(header->animations, sizeof(PackedAnimation), size)
+        || !fits(header->layers, sizeof(int32_t), size)
+        || !fits(header->emitters, sizeof(PackedEmitter), size)
+        || !fits(header->steps, sizeof(PackedStep), size)
+        || !fits(header->variables, sizeof(PackedValue), size)
+        || !fits(header->tables, sizeof(float), size)
+        || !fits(header->bursts, sizeof(PackedBurst), size)) {
+        return false;
+    }
+
+    m_data = data;
+    m_header = header;
+
+    auto animations = section<PackedAnimation>(header->animations);
+    auto emitters = section<PackedEmitter>(header->emitters);
+    for (uint32_t i = 0; i < header->animations.count; i++) {
+        auto const& animation = animations[i];
+        if (animation.name[kAnimationNameLength - 1] != '\0'
+            || animation.layerCount > 0xFF
+            || !inRange(animation.firstLayer, animation.layerCount, header->layers.count)
+            || !inRange(animation.firstEmitter, animation.emitterCount, header->emitters.count)) {
+            detach();
+            return false;
+        }
+        for (uint32_t e = 0; e < animation.emitterCount; e++) {
+            if (!validateEmitter(emitters[animation.firstEmitter + e], animation.layerCount)) {
+                detach();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void AnimationPack::detach() {
+    m_data = nullptr;
+    m_header = nullptr;
+}
+
+bool AnimationPack::validateValue(PackedValue const& value, uint8_t variableCount) const {
+    if (value.variable != kNoVariable && value.variable >= variableCount) return false;
+    return inRange(value.table, value.tableSize, m_header->tables.count);
+}
+
+bool AnimationPack::validatePosition(PackedPosition const& position, uint8_t variableCount) const {
+    return validateValue(position.x, variableCount)
+        && validateValue(position.y, variableCount)
+        && validateValue(position.angle, variableCount)
+        && validateValue(position.distance, variableCount);
+}
+
+bool AnimationPack::validateEmitter(PackedEmitter const& emitter, uint32_t layerCount) const {
+    if (emitter.shape > PackedEmitter::Shape::Zoom
+        || emitter.detail > Quality::High
+        || emitter.layer >= layerCount
+        || emitter.variableCount > kMaxVariables
+        || !inRange(emitter.firstVariable, emitter.variableCount, m_header->variables.count)
+        || !inRange(emitter.firstStep, emitter.stepCount, m_header->steps.count)) {
+        return false;
+    }
+
+    // A variable may only refer to the ones declared before it
+    auto variables = section<PackedValue>(m_header->variables) + emitter.firstVariable;
+    for (uint8_t v = 0; v < emitter.variableCount; v++) {
+        if (!validateValue(variables[v], v)) return false;
+    }
+
+    uint8_t count = emitter.variableCount;
+    if (!validateValue(emitter.zOrder, count) || !validatePosition(emitter.position, count)
+        || !validateValue(emitter.scale, count) || !validateValue(emitter.width, count)
+        || !validateValue(emitter.rotation, count) || !validateValue(emitter.opacity, count)) {
+        return false;
+    }
+    for (auto const& channel : emitter.color) {
+        if (!validateValue(channel, count)) return false;
+    }
+    if (emitter.shape == PackedEmitter::Shape::Burst) {
+        if (emitter.burst >= m_header->bursts.count) return false;
+        if (!validateBurst(section<PackedBurst>(m_header->bursts)[emitter.burst], count)) return false;
+    }
+
+    auto steps = section<PackedStep>(m_header->steps) + emitter.firstStep;
+    for (uint32_t s = 0; s < emitter.stepCount; s++) {
+        auto const& step = steps[s];
+        if (step.op > PackedStep::Op::Repeat || step.ease > Ease::Arc) return false;
+        if (step.op == PackedStep::Op::Repeat && (step.count > kMaxRepeat || step.body > emitter.stepCount - s - 1)) {
+            return false;
+        }
+        if (!validateValue(step.duration, count) || !validatePosition(step.position, count)
+            || !validateValue(step.value, count)) {
+            return false;
+        }
+        for (auto const& channel : step.color) {
+            if (!validateValue(channel, count)) return false;
+        }
+    }
+    return true;
+}
+
+bool AnimationPack::validateBurst(PackedBurst const& burst, uint8_t variableCount) const {
+    if (burst.ease > Ease::InOut) return false;
+    return validateValue(burst.delay, variableCount)
+        && validateValue(burst.life, variableCount)
+        && validatePosition(burst.to, variableCount)
+        && validateValue(burst.height, variableCount)
+        && validateValue(burst.spin, variableCount)
+        && validateValue(burst.peakScale, variableCount)
+        && validateValue(burst.peakTime, variableCount)
+        && validateValue(burst.endScale, variableCount)
+        && validateValue(burst.fade, variableCount);
+}
+
+// ===============================================================================================
+// EXPANSION
+
+const PackedAnimation* AnimationPack::getAnimation(size_t index) const {
+    if (!m_header || index >= m_header->animations.count) return nullptr;
+    return &section<PackedAnimation>(m_header->animations)[index];
+}
+
+float AnimationPack::evaluate(PackedValue const& value, uint32_t index, const float* variables, Random& random) const {
+    float result = value.base + value.step * index;
+    if (value.random != 0.0f) {
+        result += value.random * random.next();
+    }
+    if (value.tableSize) {
+        result += section<float>(m_header->tables)[value.table + index % value.tableSize];
+    }
+    if ((value.flags & PackedValue::RandomSign) && random.next() < 0.5f) {
+        result = -result;
+    }
+    if (value.variable != kNoVariable) {
+        result *= variables[value.variable];
+    }
+    return result;
+}
+
+void AnimationPack::evaluatePosition(PackedPosition const& position, uint32_t index, const float* variables, Random& random, float& x, float& y) const {
+    x = evaluate(position.x, index, variables, random);
+    y = evaluate(position.y, index, variables, random);
+
+    float distance = evaluate(position.distance, index, variables, random);
+    if (distance != 0.0f) {
+        float angle = evaluate(position.angle, index, variables, random) * kDegreesToRadians;
+        x += cosf(angle) * distance;
+        y += sinf(angle) * distance;
+    }
+}
+
+bool AnimationPack::expand(PackedAnimation const& animation, Context const& context, Random& random, TimelineBuilder& timeline) const {
+    auto layers = section<int32_t>(m_header->layers) + animation.firstLayer;
+    auto emitters = section<PackedEmitter>(m_header->emitters) + animation.firstEmitter;
+
+    for (uint32_t e = 0; e < animation.emitterCount; e++) {
+        if (emitters[e].shape == PackedEmitter::Shape::Player && !context.hasPlayer) return false;
+    }
+    for (uint32_t layer = 0; layer < animation.layerCount; layer++) {
+        timeline.addLayer(layers[layer]);
+    }
+
+    for (uint32_t e = 0; e < animation.emitterCount; e++) {
+        auto const& emitter = emitters[e];
+        if (emitter.shape == PackedEmitter::Shape::Burst) {
+            expandBurst(emitter, context, random, timeline);
+            continue;
+        }
+        // Split between the players rather than repeated for each, so dual mode costs what one
+        // death does. The player itself and single fragments go to both, full-screen ones once
+        bool fullScreen = emitter.shape == PackedEmitter::Shape::Overlay
+            || (emitter.shape >= PackedEmitter::Shape::Tint && emitter.shape != PackedEmitter::Shape::Shockwave);
+        bool everyPlayer = !fullScreen && (emitter.shape == PackedEmitter::Shape::Player || emitter.count == 1);
+        for (uint32_t index = 0; index < emitter.count; index++) {
+            Quality detail = detailFor(emitter, index);
+            if (detail > context.quality) continue;
+
+            if (everyPlayer) {
+                for (uint8_t origin = 0; origin < context.players; origin++) {
+                    expandFragment(emitter, index, detail, origin, context, random, timeline);
+                }
+            } else {
+                auto origin = static_cast<uint8_t>(fullScreen ? 0 : index % context.players);
+                expandFragment(emitter, index, detail, origin, context, random, timeline);
+            }
+        }
+    }
+    return true;
+}
+
+void AnimationPack::expandFragment(
+    PackedEmitter const& emitter, uint32_t index, Quality detail, uint8_t origin,
+    Context const& context, Random& random, TimelineBuilder& timeline
+) const {
+    auto variableValues = section<PackedValue>(m_header->variables);
+
+    float variables[kMaxVariables];
+    for (uint8_t v = 0; v < emitter.variableCount; v++) {
+        variables[v] = evaluate(variableValues[emitter.firstVariable + v], index, variables, random);
+    }
+
+    TimelineBuilder::State state;
+    if (emitter.shape != PackedEmitter::Shape::Player) {
+        evaluatePosition(emitter.position, index, variables, random, state.x, state.y);
+        state.scale = evaluate(emitter.scale, index, variables, random);
+        state.rotation = evaluate(emitter.rotation, index, variables, random);
+        state.opacity = toByte(evaluate(emitter.opacity, index, variables, random));
+    }
+    state.r = toByte(evaluate(emitter.color[0], index, variables, random));
+    state.g = toByte(evaluate(emitter.color[1], index, variables, random));
+    state.b = toByte(evaluate(emitter.color[2], index, variables, random));
+
+    Timeline::Target target = Timeline::Target::Fragment;
+    if (emitter.shape == PackedEmitter::Shape::Player) {
+        target = Timeline::Target::Player;
+    } else if (emitter.shape == PackedEmitter::Shape::Overlay) {
+        target = Timeline::Target::Overlay;
+    } else if (emitter.shape == PackedEmitter::Shape::Column) {
+        // Centered on the screen, whatever the height the player died at
+        state.y = 0.0f;
+    } else if (emitter.shape >= PackedEmitter::Shape::Tint) {
+        target = Timeline::Target::Effect;
+    }
+
+    int zOrder = static_cast<int>(evaluate(emitter.zOrder, index, variables, random));
+    auto fragment = timeline.add(target, emitter.layer, zOrder, state);
+    fragment.setDetail(detail);
+    fragment.setOrigin(origin);
+    if (target == Timeline::Target::Effect) {
+        // Shapes and effects are declared in the same order
+        auto offset = static_cast<uint8_t>(emitter.shape) - static_cast<uint8_t>(PackedEmitter::Shape::Tint);
+        fragment.setEffect(static_cast<Effect>(static_cast<uint8_t>(Effect::Tint) + offset));
+    }
+    if (emitter.shape == PackedEmitter::Shape::Column) {
+        fragment.setCentered();
+        fragment.setScaleXY(evaluate(emitter.width, index, variables, random), context.winHeight / context.fragmentHeight);
+    }
+    run(fragment, emitter.firstStep, emitter.stepCount, index, variables, random);
+}
+
+void AnimationPack::expandBurst(PackedEmitter const& emitter, Context const& context, Random& random, TimelineBuilder& timeline) const {
+    auto const& motion = section<PackedBurst>(m_header->bursts)[emitter.burst];
+    auto variableValues = section<PackedValue>(m_header->variables);
+
+    // Created with the first particle that makes the cut, whose variables the Z-order may use
+    ParticleBurst* burst = nullptr;
+    for (uint32_t index = 0; index < emitter.count; index++) {
+        Quality detail = detailFor(emitter, index);
+        if (detail > context.quality) continue;
+
+        float variables[kMaxVariables];
+        for (uint8_t v = 0; v < emitter.variableCount; v++) {
+            variables[v] = evaluate(variableValues[emitter.firstVariable + v], index, variables, random);
+        }
+        if (!burst) {
+            int zOrder = static_cast<int>(evaluate(emitter.zOrder, index, variables, random));
+            burst = &timeline.addBurst(emitter.layer, zOrder, motion.ease, motion.rate);
+        }
+
+        ParticleBurst::Particle particle;
+        particle.detail = detail;
+        particle.origin = static_cast<uint8_t>(index % context.players);
+        evaluatePosition(emitter.position, index, variables, random, particle.x, particle.y);
+        particle.scale = evaluate(emitter.scale, index, variables, random);
+        particle.rotation = evaluate(emitter.rotation, index, variables, random);
+        particle.opacity = evaluate(emitter.opacity, index, variables, random);
+        particle.r = toByte(evaluate(emitter.color[0], index, variables, random));
+        particle.g = toByte(evaluate(emitter.color[1], index, variables, random));
+        particle.b = toByte(evaluate(emitter.color[2], index, variables, random));
+
+        particle.start = evaluate(motion.delay, index, variables, random);
+        particle.life = evaluate(motion.life, index, variables, random);
+        evaluatePosition(motion.to, index, variables, random, particle.toX, particle.toY);
+        particle.height = evaluate(motion.height, index, variables, random);
+        particle.spin = evaluate(motion.spin, index, variables, random);
+        particle.peakScale = particle.scale;
+        if (motion.flags & PackedBurst::HasPeak) {
+            particle.peakScale = evaluate(motion.peakScale, index, variables, random);
+            particle.peakTime = evaluate(motion.peakTime, index, variables, random);
+        }
+        particle.endScale = particle.peakScale;
+        if (motion.flags & PackedBurst::HasEndScale) {
+            particle.endScale = evaluate(motion.endScale, index, variables, random);
+        }
+        particle.fade = evaluate(motion.fade, index, variables, random);
+        burst->add(particle);
+    }
+}
+
+void AnimationPack::run(
+    TimelineBuilder::FragmentBuilder& fragment, uint32_t first, uint32_t count,
+    uint32_t index, const float* variables, Random& random
+) const {
+    auto steps = section<PackedStep>(m_header->steps);
+
+    for (uint32_t s = first; s < first + count; s++) {
+        auto const& step = steps[s];
+        if (step.op == PackedStep::Op::Repeat) {
+            for (uint32_t i = 0; i < step.count; i++) {
+                run(fragment, s + 1, step.body, index, variables, random);
+            }
+            s += step.body;
+            continue;
+        }
+
+        float duration = evaluate(step.duration, index, variables, random);
+        float x = 0.0f;
+        float y = 0.0f;
+        switch (step.op) {
+            case PackedStep::Op::Wait:
+                fragment.wait(duration);
+                break;
+            case PackedStep::Op::After:
+                fragment.after(duration);
+                break;
+            case PackedStep::Op::MoveTo:
+                evaluatePosition(step.position, index, variables, random, x, y);
+                fragment.moveTo(duration, x, y, step.ease, step.rate);
+                break;
+            case PackedStep::Op::MoveBy:
+                evaluatePosition(step.position, index, variables, random, x, y);
+                fragment.moveBy(duration, x, y, step.ease, step.rate);
+                break;
+            case PackedStep::Op::JumpTo:
+                evaluatePosition(step.position, index, variables, random, x, y);
+                fragment.jumpTo(duration, x, y, evaluate(step.value, index, variables, random));
+                break;
+            case PackedStep::Op::ScaleTo:
+                fragment.scaleTo(duration, evaluate(step.value, index, variables, random), step.ease, step.rate);
+                break;
+            case PackedStep::Op::RotateBy:
+                fragment.rotateBy(duration, evaluate(step.value, index, variables, random));
+                break;
+            case PackedStep::Op::TintTo:
+                fragment.tintTo(
+                    duration,
+                    toByte(evaluate(step.color[0], index, variables, random)),
+                    toByte(evaluate(step.color[1], index, variables, random)),
+                    toByte(evaluate(step.color[2], index, variables, random))
+                );
+                break;
+            case PackedStep::Op::FadeTo:
+                fragment.fadeTo(duration, evaluate(step.value, index, variables, random));
+                break;
+            case PackedStep::Op::Remove:
+                fragment.remove();
+                break;
+            case PackedStep::Op::Repeat:
+                break;
+        }
+    }
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "Random.hpp"
+#include "Timeline.hpp"
+
+// Precompiled animation definitions, in the exact layout of the on-disk cache.
+// Every record is plain data with 4-byte alignment and refers to other records by index,
+// so a memory-mapped cache is used in place without parsing anything.
+
+constexpr uint32_t kAnimationPackMagic = 0x4B505354;   // "TSPK"
+constexpr uint32_t kAnimationPackVersion = 4;
+constexpr uint8_t kNoVariable = 0xFF;
+constexpr uint8_t kMaxVariables = 8;
+constexpr uint32_t kMaxRepeat = 1000;
+constexpr size_t kAnimationNameLength = 32;
+
+// base + step * index + random * roll, plus table[index % size], optionally with a
+// random sign and multiplied by one of the fragment's variables
+struct PackedValue {
+    enum Flags : uint8_t {
+        RandomSign = 1 << 0
+    };
+
+    float base;
+    float step;
+    float random;
+    uint32_t table;
+    uint16_t tableSize;
+    uint8_t variable;
+    uint8_t flags;
+};
+
+// x/y plus a polar offset: (x + cos(angle) * distance, y + sin(angle) * distance), angle in degrees
+struct PackedPosition {
+    PackedValue x;
+    PackedValue y;
+    PackedValue angle;
+    PackedValue distance;
+};
+
+struct PackedStep {
+    enum class Op : uint8_t {
+        Wait,       // args: -
+        After,      // args: -
+        MoveTo,     // position
+        MoveBy,     // position
+        JumpTo,     // position, value = height
+        ScaleTo,    // value
+        RotateBy,   // value
+        TintTo,     // color
+        FadeTo,     // value
+        Remove,     // -
+        Repeat      // `count` times the next `body` steps
+    };
+
+    Op op;
+    Ease ease;
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t body;
+    float rate;
+    PackedValue duration;
+    PackedPosition position;
+    PackedValue value;
+    PackedValue color[3];
+};
+
+struct PackedEmitter {
+    enum class Shape : uint8_t {
+        Fragment,
+        Player,     // starts from the player itself (its rotation is added at spawn); only the color is taken from here
+        Overlay,
+        Column,     // a fragment stretched over the full screen height, centered on it vertically
+        Burst,      // particles moved by a ParticleBurst, `burst` holds their motion instead of steps
+        Tint,       // the rest are post-process effects, see Effect
+        Flash,
+        Vignette,
+        Shockwave,
+        Zoom
+    };
+
+    Shape shape;
+    uint8_t layer;
+    uint8_t variableCount;
+    Quality detail;     // lowest quality tier that shows this emitter at all
+    uint32_t count;
+    uint32_t firstVariable;
+    uint32_t firstStep;
+    uint32_t stepCount;
+    uint32_t burst;
+    PackedValue zOrder;
+    PackedPosition position;
+    PackedValue scale;
+    PackedValue width;
+    PackedValue rotation;
+    PackedValue color[3];
+    PackedValue opacity;
+};
+
+// Motion of every particle of a burst emitter; launch position, scale, rotation, color and
+// opacity still come from the emitter
+struct PackedBurst {
+    enum Flags : uint8_t {
+        HasPeak = 1 << 0,       // scale goes through peakScale at peakTime
+        HasEndScale = 1 << 1    // otherwise the scale holds where it was
+    };
+
+    Ease ease;
+    uint8_t flags;
+    uint16_t reserved;
+    float rate;
+    PackedValue delay;
+    PackedValue life;
+    PackedPosition to;
+    PackedValue height;
+    PackedValue spin;
+    PackedValue peakScale;
+    PackedValue peakTime;
+    PackedValue endScale;
+    PackedValue fade;
+};
+
+struct PackedAnimation {
+    char name[kAnimationNameLength];
+    uint32_t firstLayer;
+    uint32_t layerCount;
+    uint32_t firstEmitter;
+    uint32_t emitterCount;
+};
+
+struct PackedSection {
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct PackedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fingerprint;   // of the source files this pack was compiled from
+    PackedSection animations;
+    PackedSection layers;       // int32_t Z-orders
+    PackedSection emitters;
+    PackedSection steps;
+    PackedSection variables;    // PackedValue
+    PackedSection tables;       // float
+    PackedSection bursts;
+};
+
+// Read-only view over a compiled pack. attach() validates every index once,
+// so expand() can trust the data even when it comes from a cache file on disk.
+class AnimationPack {
+public:
+    // Nothing in here depends on where the player dies, so an animation can be built ahead of time
+    struct Context {
+        float winWidth = 0.0f;
+        float winHeight = 0.0f;
+        float fragmentHeight = 1.0f;
+        Quality quality = Quality::High;   // fragments above this tier are not built
+        bool hasPlayer = true;             // player emitters animate the player from its own position
+        uint8_t players = 1;               // dual mode splits every emitter between both players
+    };
+
+    bool attach(const uint8_t* data, size_t size);
+    void detach();
+
+    const PackedAnimation* getAnimation(size_t index) const;
+    bool expand(PackedAnimation const& animation, Context const& context, Random& random, TimelineBuilder& timeline) const;
+
+    uint64_t getFingerprint() const { return m_header ? m_header->fingerprint : 0; }
+    size_t getAnimationCount() const { return m_header ? m_header->animations.count : 0; }
+
+private:
+    template <class T>
+    const T* section(PackedSection const& section) const {
+        return reinterpret_cast<const T*>(m_data + section.offset);
+    }
+
+    bool validateValue(PackedValue const& value, uint8_t variableCount) const;
+    bool validatePosition(PackedPosition const& position, uint8_t variableCount) const;
+    bool validateEmitter(PackedEmitter const& emitter, uint32_t layerCount) const;
+    bool validateBurst(PackedBurst const& burst, uint8_t variableCount) const;
+
+    float evaluate(PackedValue const& value, uint32_t index, const float* variables, Random& random) const;
+    void evaluatePosition(PackedPosition const& position, uint32_t index, const float* variables, Random& random, float& x, float& y) const;
+    void expandFragment(
+        PackedEmitter const& emitter, uint32_t index, Quality detail, uint8_t origin,
+        Context const& context, Random& random, TimelineBuilder& timeline
+    ) const;
+    void expandBurst(PackedEmitter const& emitter, Context const& context, Random& random, TimelineBuilder& timeline) const;
+    void run(
+        TimelineBuilder::FragmentBuilder& fragment, uint32_t first, uint32_t count,
+        uint32_t index, const float* variables, Random& random
+    ) const;
+
+    const uint8_t* m_data = nullptr;
+    const PackedHeader* m_header = nullptr;
+};
@@ -0,0 +1,408 @@
+#include <Geode/Geode.hpp>
+#include "AnimationRunner.hpp"
+#include "Trace.hpp"
+#include <bit>
+
+using namespace geode::prelude;
+
+namespace {
+    constexpr uint8_t channelBit(Timeline::Channel channel) {
+        return static_cast<uint8_t>(1 << channel);
+    }
+
+    constexpr uint8_t kPositionBits = channelBit(Timeline::X) | channelBit(Timeline::Y);
+    constexpr uint8_t kColorBits = channelBit(Timeline::Red) | channelBit(Timeline::Green) | channelBit(Timeline::Blue);
+    constexpr uint8_t kAllBits = 0xFF;
+
+    // The spawn frame is skipped, then this many frames decide whether the tier holds
+    constexpr uint32_t kSampleFrames = 10;
+    constexpr float kBudgetTolerance = 1.15f;
+
+    GLubyte toByte(float value) {
+        return static_cast<GLubyte>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+    }
+}
+
+AnimationRunner* AnimationRunner::create(PlayLayer* playLayer, AnimationLayer* layer, Timeline&& timeline, std::vector<CCPoint> const& origins, Quality quality) {
+    auto ret = new AnimationRunner();
+    if (ret->init(playLayer, layer, std::move(timeline), origins, quality)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool AnimationRunner::init(PlayLayer* playLayer, AnimationLayer* layer, Timeline&& timeline, std::vector<CCPoint> const& origins, Quality quality) {
+    if (!CCNode::init() || origins.empty()) return false;
+
+    m_quality = quality;
+    m_playLayer = playLayer;
+    m_layer = layer;
+    m_pool = &layer->getPool();
+    m_postProcess = layer->getPostProcess();
+    m_timeline = std::move(timeline);
+    // Deaths are in the object layer, scrolled along with the level; everything but the players
+    // is drawn and culled on screen, where this layer is
+    m_playerOrigins = origins;
+    m_playerOrigins.resize(Timeline::kMaxOrigins, origins.front());
+    for (auto const& origin : m_playerOrigins) {
+        m_origins.push_back(layer->toLayerSpace(origin));
+    }
+    m_winSize = CCDirector::get()->getWinSize();
+    m_centerY = m_winSize.height / 2;
+    auto fragmentSize = m_pool->getFragmentSize();
+    m_cullRadius = std::sqrt(fragmentSize.width * fragmentSize.width + fragmentSize.height * fragmentSize.height) / 2;
+    m_fragmentRadius = fragmentSize.height / 2;
+
+    size_t count = m_timeline.getFragments().size();
+    m_nodes.assign(count, nullptr);
+    m_colors.assign(count, nullptr);
+    m_states.assign(count, State::Pending);
+    m_cursors.assign(count * Timeline::ChannelCount, 0);
+
+    for (int zOrder : m_timeline.getLayers()) {
+        auto batch = m_pool->checkoutBatch();
+        batch->setZOrder(zOrder);
+        layer->addChild(batch);
+        m_batches.push_back(batch);
+    }
+
+    // Bursts draw right above their layer's batch, they are added after it at the same Z-order
+    for (auto& burst : m_timeline.getBursts()) {
+        burst.retireAbove(m_quality);
+        auto node = BurstNode::create(&burst, m_pool->checkoutAtlas(burst.size()), m_origins);
+        layer->addChild(node, m_timeline.getLayers()[burst.getLayer()]);
+        m_bursts.push_back(node);
+    }
+
+    // Everything that starts immediately is visible on the new-best frame itself
+    for (size_t fragment = 0; fragment < count; fragment++) {
+        auto const& desc = m_timeline.getFragments()[fragment];
+        if (desc.detail > m_quality) {
+            m_states[fragment] = State::Retired;
+        } else if (desc.start <= 0.0f) {
+            spawn(fragment);
+        }
+    }
+
+    layer->addChild(this);
+    this->scheduleUpdate();
+    Trace::begin(TraceEvent::Animation, 0.0f, 0.0f, static_cast<int32_t>(count));
+    return true;
+}
+
+void AnimationRunner::update(float dt) {
+    // Hold the animation behind the pause menu, like the new-best delay it is paired with
+    if (m_playLayer->m_isPaused) return;
+    m_time += dt;
+    if (m_adaptive) {
+        sampleFrameTime(dt);
+    }
+
+    auto const& fragments = m_timeline.getFragments();
+    m_trackCount = 0;
+    m_culledCount = 0;
+    m_postProcess->clear();
+    for (size_t fragment = 0; fragment < fragments.size(); fragment++) {
+        auto const& desc = fragments[fragment];
+        if (m_states[fragment] == State::Pending && m_time >= desc.start) {
+            spawn(fragment);
+        }
+        if (m_states[fragment] == State::Culled) {
+            if (m_time < desc.end) {
+                m_culledCount++;
+            } else {
+                m_states[fragment] = State::Retired;
+            }
+        }
+        if (m_states[fragment] != State::Active) continue;
+
+        if (m_time >= desc.end) {
+            retire(fragment);
+        } else if (m_time >= desc.hidden) {
+            retire(fragment);
+            m_states[fragment] = State::Culled;
+            m_culledCount++;
+        } else if (desc.target == Timeline::Target::Effect) {
+            applyEffect(fragment);
+            m_trackCount += std::popcount(desc.animated);
+        } else {
+            apply(fragment, desc.animated);
+            m_trackCount += std::popcount(desc.animated);
+            if (desc.target == Timeline::Target::Fragment) {
+                cull(fragment);
+            }
+        }
+    }
+    m_savedDraws += m_culledCount;
+    m_postProcess->commit();
+
+    m_particleCount = 0;
+    for (auto burst : m_bursts) {
+        m_particleCount += burst->advance(m_time);
+    }
+
+    if (m_time >= m_timeline.getDuration()) {
+        finish();
+    }
+}
+
+void AnimationRunner::sampleFrameTime(float dt) {
+    // The first update measures the frame that built the animation, not the animation itself
+    if (m_time == dt) return;
+
+    m_sampledTime += dt;
+    if (++m_sampledFrames < kSampleFrames) return;
+
+    m_lastAverage = m_sampledTime / m_sampledFrames;
+    m_sampledFrames = 0;
+    m_sampledTime = 0.0f;
+
+    float budget = static_cast<float>(CCDirector::get()->getAnimationInterval());
+    if (m_lastAverage > budget * kBudgetTolerance && m_quality > Quality::Low) {
+        lowerQuality();
+    } else {
+        m_adaptive = false;
+    }
+}
+
+void AnimationRunner::lowerQuality() {
+    m_quality = static_cast<Quality>(static_cast<uint8_t>(m_quality) - 1);
+    m_lowered = true;
+    Trace::instant(TraceEvent::QualityLowered, m_lastAverage * 1000.0f, 0.0f, static_cast<int32_t>(m_quality));
+
+    auto const& fragments = m_timeline.getFragments();
+    for (size_t fragment = 0; fragment < fragments.size(); fragment++) {
+        if (fragments[fragment].detail <= m_quality) continue;
+        if (m_states[fragment] == State::Active) {
+            retire(fragment);
+        }
+        m_states[fragment] = State::Retired;
+    }
+    for (auto& burst : m_timeline.getBursts()) {
+        burst.retireAbove(m_quality);
+    }
+}
+
+Quality AnimationRunner::getSuggestedQuality() const {
+    // Step back up one tier at a time once an animation has run comfortably within budget
+    float budget = static_cast<float>(CCDirector::get()->getAnimationInterval());
+    if (!m_lowered && m_quality < Quality::High && m_lastAverage > 0.0f && m_lastAverage <= budget) {
+        return static_cast<Quality>(static_cast<uint8_t>(m_quality) + 1);
+    }
+    return m_quality;
+}
+
+void AnimationRunner::spawn(size_t fragment) {
+    auto const& desc = m_timeline.getFragments()[fragment];
+
+    switch (desc.target) {
+        case Timeline::Target::Fragment: {
+            auto sprite = m_pool->checkout();
+            m_batches[desc.layer]->addChild(sprite, desc.zOrder);
+            m_nodes[fragment] = sprite;
+            m_colors[fragment] = sprite;
+            break;
+        }
+        case Timeline::Target::Player: {
+            // The second origin only exists in dual mode; alone, either icon will do
+            auto player = desc.origin == 1 ? m_playLayer->m_player2
+                : m_playLayer->m_player1 ? m_playLayer->m_player1 : m_playLayer->m_player2;
+            if (!player) {
+                m_states[fragment] = State::Retired;
+                return;
+            }
+            player->stopAllActions();
+            m_playerRotations[desc.origin] = player->getRotation();
+            m_nodes[fragment] = player;
+            m_colors[fragment] = player;
+            break;
+        }
+        case Timeline::Target::Overlay: {
+            auto overlay = m_pool->checkoutOverlay();
+            overlay->setContentSize(CCDirector::get()->getWinSize());
+            overlay->setPosition(CCPointZero);
+            overlay->setZOrder(desc.zOrder);
+            m_layer->addChild(overlay);
+            m_nodes[fragment] = overlay;
+            m_colors[fragment] = overlay;
+            break;
+        }
+        case Timeline::Target::Effect:
+            // No node; its values are gathered into the post-process every frame by update()
+            m_states[fragment] = State::Active;
+            m_activeCount++;
+            return;
+    }
+
+    m_states[fragment] = State::Active;
+    m_activeCount++;
+    apply(fragment, kAllBits);
+}
+
+void AnimationRunner::retire(size_t fragment) {
+    auto node = m_nodes[fragment];
+    switch (m_timeline.getFragments()[fragment].target) {
+        case Timeline::Target::Fragment:
+            m_pool->release(static_cast<CCSprite*>(node));
+            break;
+        case Timeline::Target::Overlay:
+            m_pool->releaseOverlay(static_cast<CCLayerColor*>(node));
+            break;
+        case Timeline::Target::Player:
+        case Timeline::Target::Effect:
+            break;
+    }
+
+    m_nodes[fragment] = nullptr;
+    m_colors[fragment] = nullptr;
+    m_states[fragment] = State::Retired;
+    m_activeCount--;
+}
+
+void AnimationRunner::apply(size_t fragment, uint8_t channels) {
+    auto const& desc = m_timeline.getFragments()[fragment];
+    auto node = m_nodes[fragment];
+    uint32_t* cursors = &m_cursors[fragment * Timeline::ChannelCount];
+    auto value = [&](Timeline::Channel channel) {
+        return m_timeline.evaluate(fragment, channel, m_time, cursors[channel]);
+    };
+
+    if (desc.target != Timeline::Target::Overlay) {
+        if (channels & kPositionBits) {
+            node->setPosition(positionOf(desc, value(Timeline::X), value(Timeline::Y)));
+        }
+        if (channels & channelBit(Timeline::Scale)) {
+            float scale = value(Timeline::Scale);
+            if (desc.scaleX == 1.0f && desc.scaleY == 1.0f) {
+                node->setScale(scale);
+            } else {
+                node->setScaleX(scale * desc.scaleX);
+                node->setScaleY(scale * desc.scaleY);
+            }
+        }
+        if (channels & channelBit(Timeline::Rotation)) {
+            float base = desc.target == Timeline::Target::Player ? m_playerRotations[desc.origin] : 0.0f;
+            node->setRotation(base + value(Timeline::Rotation));
+        }
+    }
+
+    if (channels & kColorBits) {
+        m_colors[fragment]->setColor(ccc3(
+            toByte(value(Timeline::Red)),
+            toByte(value(Timeline::Green)),
+            toByte(value(Timeline::Blue))
+        ));
+    }
+    if (channels & channelBit(Timeline::Opacity)) {
+        m_colors[fragment]->setOpacity(toByte(value(Timeline::Opacity)));
+    }
+}
+
+CCPoint AnimationRunner::positionOf(Timeline::Fragment const& desc, float x, float y) const {
+    auto const& origin = desc.target == Timeline::Target::Player ? m_playerOrigins[desc.origin] : m_origins[desc.origin];
+    return ccp(origin.x + x, (desc.centered ? m_centerY : origin.y) + y);
+}
+
+void AnimationRunner::applyEffect(size_t fragment) {
+    auto const& desc = m_timeline.getFragments()[fragment];
+    uint32_t* cursors = &m_cursors[fragment * Timeline::ChannelCount];
+    auto value = [&](Timeline::Channel channel) {
+        return m_timeline.evaluate(fragment, channel, m_time, cursors[channel]);
+    };
+
+    auto color = ccc3(toByte(value(Timeline::Red)), toByte(value(Timeline::Green)), toByte(value(Timeline::Blue)));
+    float strength = std::clamp(value(Timeline::Opacity) / 255.0f, 0.0f, 1.0f);
+    auto position = [&]() {
+        return positionOf(desc, value(Timeline::X), value(Timeline::Y));
+    };
+
+    switch (desc.effect) {
+        case Effect::Tint:
+            m_postProcess->addTint(color, strength);
+            break;
+        case Effect::Flash:
+            m_postProcess->addFlash(color, strength);
+            break;
+        case Effect::Vignette:
+            m_postProcess->addVignette(color, strength);
+            break;
+        case Effect::Shockwave:
+            m_postProcess->addShockwave({ position(), std::abs(value(Timeline::Scale)) * m_fragmentRadius, strength, color });
+            break;
+        case Effect::Zoom:
+            m_postProcess->addZoom(position(), value(Timeline::Scale));
+            break;
+        case Effect::None:
+            break;
+    }
+}
+
+bool AnimationRunner::isOnScreen(CCNode* node) const {
+    // A circle around the rotated, scaled sprite, cheaper than its bounding box and never too small
+    float scale = std::max(std::abs(node->getScaleX()), std::abs(node->getScaleY()));
+    float radius = m_cullRadius * scale;
+    auto position = node->getPosition();
+    return position.x + radius >= 0.0f && position.x - radius <= m_winSize.width
+        && position.y + radius >= 0.0f && position.y - radius <= m_winSize.height;
+}
+
+void AnimationRunner::cull(size_t fragment) {
+    auto node = m_nodes[fragment];
+    bool onScreen = isOnScreen(node);
+    if (!onScreen) {
+        m_culledCount++;
+        // Off screen with nothing left to move it back, it won't be seen again
+        if (m_time >= m_timeline.getFragments()[fragment].settled) {
+            retire(fragment);
+            m_states[fragment] = State::Culled;
+            return;
+        }
+    }
+    if (node->isVisible() != onScreen) {
+        node->setVisible(onScreen);
+    }
+}
+
+void AnimationRunner::stop() {
+    for (size_t fragment = 0; fragment < m_states.size(); fragment++) {
+        if (m_states[fragment] == State::Active) {
+            retire(fragment);
+        }
+    }
+    for (auto batch : m_batches) {
+        m_pool->releaseBatch(batch);
+    }
+    m_batches.clear();
+    for (auto burst : m_bursts) {
+        m_pool->releaseAtlas(burst->getAtlas());
+        burst->removeFromParentAndCleanup(true);
+    }
+    m_bursts.clear();
+
+    m_postProcess->clear();
+    m_postProcess->commit();
+
+    Trace::end(TraceEvent::Animation, 0.0f, 0.0f, static_cast<int32_t>(m_savedDraws));
+    m_finished = true;
+    m_trackCount = 0;
+    m_particleCount = 0;
+    this->unscheduleUpdate();
+}
+
+void AnimationRunner::finish() {
+    stop();
+    if (m_finishCallback) {
+        m_finishCallback();
+    }
+    this->removeFromParentAndCleanup(true);
+}
+
+void AnimationRunner::cancel() {
+    if (m_finished) return;
+
+    // A borrowed player is left where it is, the reset that cancels us restores it
+    stop();
+    this->removeFromParentAndCleanup(true);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "AnimationLayer.hpp"
+#include "BurstNode.hpp"
+#include "Timeline.hpp"
+
+using namespace geode::prelude;
+
+// Plays a Timeline on the PlayLayer. One scheduled update evaluates the tracks of every live
+// fragment and applies them, instead of a CCSequence/CCSpawn tree running on each sprite.
+// Fragments are checked out of the layer's pool when the animation starts and handed back on retire.
+// Fragments outside the screen are hidden, and retired early once they can't come back or once
+// they have faded or shrunk away for good; every frame they would have been drawn counts as saved.
+// In dual mode one runner plays both players' share of the animation, each from its own origin.
+class AnimationRunner : public CCNode {
+public:
+    static AnimationRunner* create(PlayLayer* playLayer, AnimationLayer* layer, Timeline&& timeline, std::vector<CCPoint> const& origins, Quality quality = Quality::High);
+
+    // Adaptive quality: frame times are sampled while the animation starts, and if they miss the
+    // frame budget the runner drops a tier and retires the fragments above it
+    void setAdaptiveQuality(bool adaptive) { m_adaptive = adaptive; }
+    Quality getQuality() const { return m_quality; }
+    Quality getSuggestedQuality() const;
+
+    void setFinishCallback(std::function<void()> callback) { m_finishCallback = std::move(callback); }
+    void update(float dt) override;
+
+    // Stops at once without the finish callback, for resets and level exits
+    void cancel();
+
+    size_t getActiveCount() const { return m_activeCount; }
+    size_t getTrackCount() const { return m_trackCount; }   // animated channels evaluated last frame, the old running action count
+    size_t getParticleCount() const { return m_particleCount; }
+    size_t getCulledCount() const { return m_culledCount; }     // fragments not drawn last frame
+    size_t getSavedDraws() const { return m_savedDraws; }       // fragment draws skipped so far
+    bool isFinished() const { return m_finished; }
+
+private:
+    enum class State : uint8_t { Pending, Active, Culled, Retired };   // Culled retired before its end
+
+    bool init(PlayLayer* playLayer, AnimationLayer* layer, Timeline&& timeline, std::vector<CCPoint> const& origins, Quality quality);
+    CCPoint positionOf(Timeline::Fragment const& desc, float x, float y) const;
+    void sampleFrameTime(float dt);
+    void lowerQuality();
+    void spawn(size_t fragment);
+    void retire(size_t fragment);
+    void apply(size_t fragment, uint8_t channels);
+    void cull(size_t fragment);
+    void applyEffect(size_t fragment);
+    bool isOnScreen(CCNode* node) const;
+    void stop();
+    void finish();
+
+    PlayLayer* m_playLayer = nullptr;
+    AnimationLayer* m_layer = nullptr;
+    FragmentPool* m_pool = nullptr;
+    PostProcess* m_postProcess = nullptr;
+    Timeline m_timeline;
+    std::vector<CCPoint> m_origins;     // one per player in our space, the first repeated when there is only one
+    std::vector<CCPoint> m_playerOrigins;   // the same in the object layer, for the borrowed players
+    float m_centerY = 0.0f;             // centered fragments are placed from here instead of the origin
+    float m_playerRotations[Timeline::kMaxOrigins] = {};    // each player's own rotation when it was taken over
+    float m_time = 0.0f;
+    size_t m_activeCount = 0;
+    size_t m_trackCount = 0;
+    size_t m_particleCount = 0;
+    size_t m_culledCount = 0;
+    size_t m_savedDraws = 0;
+    float m_cullRadius = 0.0f;          // half the diagonal of an unscaled fragment
+    float m_fragmentRadius = 0.0f;      // half its height, the radius of a shockwave at scale 1
+    CCSize m_winSize;
+    bool m_finished = false;
+
+    Quality m_quality = Quality::High;
+    bool m_adaptive = false;
+    bool m_lowered = false;
+    uint32_t m_sampledFrames = 0;
+    float m_sampledTime = 0.0f;
+    float m_lastAverage = 0.0f;
+
+    std::vector<CCSpriteBatchNode*> m_batches;
+    std::vector<BurstNode*> m_bursts;
+    std::vector<CCNode*> m_nodes;
+    std::vector<CCRGBAProtocol*> m_colors;
+    std::vector<State> m_states;
+    std::vector<uint32_t> m_cursors;
+    std::function<void()> m_finishCallback;
+};
@@ -0,0 +1,85 @@
+#include <Geode/Geode.hpp>
+#include "BurstNode.hpp"
+
+using namespace geode::prelude;
+
+namespace {
+    constexpr float kDegreesToRadians = 3.14159265f / 180.0f;
+}
+
+BurstNode* BurstNode::create(ParticleBurst* burst, CCTextureAtlas* atlas, std::vector<CCPoint> const& origins) {
+    auto ret = new BurstNode();
+    if (ret->init(burst, atlas, origins)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool BurstNode::init(ParticleBurst* burst, CCTextureAtlas* atlas, std::vector<CCPoint> const& origins) {
+    if (!CCNode::init()) return false;
+
+    m_burst = burst;
+    m_origins = origins;
+    m_atlas = atlas;
+    auto size = atlas->getTexture()->getContentSize();
+    m_halfSize = CCSize(size.width / 2, size.height / 2);
+    this->setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
+    return true;
+}
+
+size_t BurstNode::advance(float time) {
+    size_t alive = m_burst->step(time);
+
+    auto x = m_burst->getX();
+    auto y = m_burst->getY();
+    auto rotation = m_burst->getRotation();
+    auto scale = m_burst->getScale();
+    auto alpha = m_burst->getAlpha();
+    auto colors = m_burst->getColors();
+    auto origins = m_burst->getOrigins();
+    auto quads = m_atlas->getQuads();
+
+    // Only visible particles get a quad, so the draw call covers exactly what is on screen
+    m_quadCount = 0;
+    for (size_t i = 0; i < m_burst->size(); i++) {
+        if (scale[i] <= 0.0f || alpha[i] < 0.5f) continue;
+
+        // cocos2d rotations are clockwise
+        float radians = rotation[i] * kDegreesToRadians;
+        float cos = cosf(radians) * scale[i];
+        float sin = sinf(radians) * scale[i];
+        auto const& origin = m_origins[origins[i]];
+        float centerX = origin.x + x[i];
+        float centerY = origin.y + y[i];
+        auto corner = [&](float localX, float localY) {
+            return vertex3(centerX + localX * cos + localY * sin, centerY - localX * sin + localY * cos, 0.0f);
+        };
+
+        // Premultiplied, like a CCSprite with its opacity applied to the color
+        auto opacity = static_cast<GLubyte>(alpha[i] + 0.5f);
+        ccColor4B color = {
+            static_cast<GLubyte>(colors[i].r * opacity / 255),
+            static_cast<GLubyte>(colors[i].g * opacity / 255),
+            static_cast<GLubyte>(colors[i].b * opacity / 255),
+            opacity
+        };
+
+        auto& quad = quads[m_quadCount++];
+        quad.bl = { corner(-m_halfSize.width, -m_halfSize.height), color, { 0.0f, 1.0f } };
+        quad.br = { corner(m_halfSize.width, -m_halfSize.height), color, { 1.0f, 1.0f } };
+        quad.tl = { corner(-m_halfSize.width, m_halfSize.height), color, { 0.0f, 0.0f } };
+        quad.tr = { corner(m_halfSize.width, m_halfSize.height), color, { 1.0f, 0.0f } };
+    }
+    m_atlas->setDirty(true);
+    return alive;
+}
+
+void BurstNode::draw() {
+    if (m_quadCount == 0) return;
+
+    CC_NODE_DRAW_SETUP();
+    ccGLBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    m_atlas->drawNumberOfQuads(static_cast<unsigned>(m_quadCount), 0);
+}
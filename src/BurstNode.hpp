@@ -0,0 +1,29 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "ParticleBurst.hpp"
+
+using namespace geode::prelude;
+
+// Draws a ParticleBurst as one batch of textured quads written straight from its output arrays,
+// so a burst is a single node and a single draw call however many particles it has.
+// The burst belongs to the runner's timeline and the atlas to the fragment pool, both outlive the node.
+// Each particle is drawn from its own origin, so one burst serves both players in dual mode.
+class BurstNode : public CCNode {
+public:
+    static BurstNode* create(ParticleBurst* burst, CCTextureAtlas* atlas, std::vector<CCPoint> const& origins);
+
+    // Steps the burst to `time` and rebuilds the quads, returns how many particles are alive
+    size_t advance(float time);
+    void draw() override;
+
+    CCTextureAtlas* getAtlas() const { return m_atlas; }
+
+private:
+    bool init(ParticleBurst* burst, CCTextureAtlas* atlas, std::vector<CCPoint> const& origins);
+
+    ParticleBurst* m_burst = nullptr;
+    Ref<CCTextureAtlas> m_atlas;
+    std::vector<CCPoint> m_origins;
+    CCSize m_halfSize;
+    size_t m_quadCount = 0;
+};
@@ -0,0 +1,63 @@
+#include <Geode/Geode.hpp>
+#include "Config.hpp"
+#include "DeathAnimations.hpp"
+
+using namespace geode::prelude;
+
+namespace {
+    Config s_config;
+
+    // Applies the current value now and every change after it
+    template <class T, class F>
+    void bind(std::string_view key, F apply) {
+        apply(Mod::get()->getSettingValue<T>(key));
+        listenForSettingChanges(key, [apply](T value) {
+            apply(value);
+        });
+    }
+}
+
+Config const& Config::get() {
+    return s_config;
+}
+
+void Config::load() {
+    bind<std::string>("animation-type", [](std::string value) {
+        s_config.animation = DeathAnimations::resolveAnimation(value);
+    });
+    bind<int64_t>("delay-duration", [](int64_t value) {
+        s_config.delay = static_cast<float>(value);
+    });
+    bind<bool>("grind-mode", [](bool value) { s_config.grind = value; });
+    bind<std::string>("animation-quality", [](std::string value) {
+        s_config.adaptiveQuality = value == "auto";
+        s_config.quality = value == "low" ? Quality::Low : value == "medium" ? Quality::Medium : Quality::High;
+    });
+    bind<std::string>("flipbook", [](std::string value) {
+        s_config.flipbookSize = value == "small" ? 192 : value == "large" ? 384 : 0;
+    });
+    bind<int64_t>("flipbook-fps", [](int64_t value) {
+        s_config.flipbookFps = static_cast<float>(value);
+    });
+    bind<std::string>("tombstones", [](std::string value) {
+        s_config.tombstones = value == "off" ? TombstoneMode::Off : value == "all-deaths" ? TombstoneMode::AllDeaths : TombstoneMode::NewBests;
+    });
+    bind<std::string>("heatmap", [](std::string value) {
+        s_config.heatmap = value == "off" ? HeatmapMode::Off : value == "always" ? HeatmapMode::Always : HeatmapMode::Paused;
+    });
+    bind<std::string>("skip-input", [](std::string value) {
+        s_config.skipInput = value == "jump" ? SkipInput::Jump : value == "any-button" ? SkipInput::AnyButton : SkipInput::Off;
+    });
+    bind<bool>("ghost-replay", [](bool value) { s_config.ghostReplay = value; });
+    bind<bool>("screen-effects", [](bool value) { s_config.screenEffects = value; });
+    bind<bool>("performance-overlay", [](bool value) { s_config.performanceOverlay = value; });
+    bind<bool>("trace-export", [](bool value) { s_config.traceExport = value; });
+    bind<bool>("benchmark-on-load", [](bool value) { s_config.benchmarkOnLoad = value; });
+
+    s_config.autoQuality = static_cast<Quality>(std::clamp<int64_t>(Mod::get()->getSavedValue<int64_t>("auto-quality", 2), 0, 2));
+}
+
+void Config::setAutoQuality(Quality quality) {
+    s_config.autoQuality = quality;
+    Mod::get()->setSavedValue<int64_t>("auto-quality", static_cast<int64_t>(quality));
+}
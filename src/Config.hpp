@@ -0,0 +1,43 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "Timeline.hpp"
+
+using namespace geode::prelude;
+
+enum class TombstoneMode : uint8_t { Off, NewBests, AllDeaths };
+enum class HeatmapMode : uint8_t { Off, Always, Paused };
+enum class SkipInput : uint8_t { Off, Jump, AnyButton };
+
+// Every mod setting, parsed once into plain values. Loaded after the animation definitions, so
+// the selected animation is resolved to its registry index here rather than on every new best,
+// and kept current by a listener on each setting instead of being read again where it is used.
+struct Config {
+    // Grind mode's new-best delay, the animation is squeezed into it on the low tier
+    static constexpr float kGrindDelay = 0.5f;
+
+    size_t animation = 0;           // DeathAnimations registry index
+    float delay = 5.0f;             // seconds, as set; getDelay() is what is used
+    bool grind = false;
+    Quality quality = Quality::High;
+    bool adaptiveQuality = true;
+    Quality autoQuality = Quality::High;    // where adaptive quality settled last time, saved across launches
+    uint32_t flipbookSize = 0;      // longest side of a baked frame in pixels, 0 plays everything live
+    float flipbookFps = 24.0f;
+    TombstoneMode tombstones = TombstoneMode::NewBests;
+    HeatmapMode heatmap = HeatmapMode::Paused;
+    SkipInput skipInput = SkipInput::Off;
+    bool ghostReplay = false;
+    bool screenEffects = true;
+    bool performanceOverlay = false;
+    bool traceExport = false;
+    bool benchmarkOnLoad = false;
+
+    // How long respawn waits after a new best, which every animation is scaled to fill
+    float getDelay() const { return grind ? kGrindDelay : delay; }
+    // The tier animations are built on, the one adaptive quality settled on if it is on
+    Quality getQuality() const { return grind ? Quality::Low : adaptiveQuality ? autoQuality : quality; }
+
+    static Config const& get();
+    static void load();
+    static void setAutoQuality(Quality quality);
+};
@@ -1,5 +1,15 @@
 #include <Geode/Geode.hpp>
 #include "DeathAnimations.hpp"
+#include "AnimationBenchmark.hpp"
+#include "AnimationCompiler.hpp"
+#include "AnimationPack.hpp"
+#include "AnimationRunner.hpp"
+#include "Config.hpp"
+#include "FlipbookNode.hpp"
+#include "MappedFile.hpp"
+#include "Trace.hpp"
+#include <array>
+#include <thread>
 
 using namespace geode::prelude;
 
@@ -10,983 +20,545 @@ using namespace geode::prelude;
 
 HOW TO ADD YOUR OWN ANIMATION:
 
-1. CREATE YOUR ANIMATION FUNCTION:
-   - Follow the naming pattern: void DeathAnimations::createYourNameAnimation(PlayLayer* playLayer, CCPoint playerPos)
-   - Add detailed header comment with description, duration, style, and effects
-   - Use the same function signature as existing animations
-   - Place your function before the ANIMATION SELECTOR section
+1. CREATE YOUR ANIMATION FILE:
+   - Add resources/animations/yourname.json, the file name is the animation name
+   - Use explosion.json, ascension.json and slaughterhouse.json as references
 
-2. ADD TO HEADER FILE (DeathAnimations.hpp):
-   - Add static function declaration: static void createYourNameAnimation(PlayLayer* playLayer, CCPoint playerPos);
-
-3. UPDATE MOD SETTINGS (mod.json):
+2. UPDATE MOD SETTINGS (mod.json):
    - Add your animation name to the "one-of" array in "animation-type" setting
    - Example: "one-of": ["explosion", "ascension", "slaughterhouse", "yourname"]
 
-4. UPDATE SELECTOR FUNCTION:
-   - Add your condition in createSelectedAnimation() function
-   - Example: else if (animationType == "yourname") { createYourNameAnimation(playLayer, playerPos); }
+No C++ changes are needed. Definitions are compiled once into animations.bin in the mod's
+save directory and memory-mapped on later launches, until any definition file changes.
+
+FILE FORMAT:
+{
+    "layers": [2400, 2800],             // Z-order of each fragment batch
+    "emitters": [
+        {
+            "shape": "fragment",        // fragment, player, overlay, column (full screen height), burst or an effect
+            "count": 20,                // fragments spawned by this emitter, thinned out on lower quality
+            "detail": "medium",         // lowest quality (low, medium, high) that shows this emitter
+            "layer": 0,                 // index into "layers"
+            "z": 100,                   // Z-order inside the batch
+            "position": [0, 0],         // offset from the death position, or {x, y, angle, distance}
+            "scale": 1, "width": 1, "rotation": 0, "color": [255, 255, 255], "opacity": 255,
+            "vars": { "dir": { "base": 1, "sign": true } },
+            "steps": [ ... ]
+        }
+    ]
+}
+
+Any number can also be a value object, evaluated for each fragment:
+    { "base": 100, "step": 10, "random": 50, "table": [..], "sign": true, "var": "dir" }
+    = (base + step * index + random * [0, 1) + table[index]) * random sign * dir
+
+BURSTS:
+A "burst" emitter has no steps. Its particles are moved in bulk and drawn above their layer's
+fragments, for the radial sprays that would otherwise be dozens of identical fragments:
+    "delay": 0.5, "life": 0.8,          // launch time and lifetime in seconds
+    "to": {"angle": .., "distance": ..}, "ease": "out", "rate": 3, "height": 0,
+    "spin": 720, "fade": 0.4,           // degrees over the life, fade out before the end
+    "peakScale": 2, "peakTime": 0.2, "endScale": 0.2     // optional scale keys after "scale"
+
+SCREEN EFFECTS:
+Shapes tint, flash, vignette, shockwave and zoom draw nothing themselves. Their color, opacity,
+position and scale drive one post-process pass over the whole screen, so any number of them
+costs a single full-screen draw instead of one blended layer each:
+    tint        color blended over the screen at its opacity, like an overlay
+    flash       color added to the screen, scaled by its opacity
+    vignette    color darkening the screen edges at its opacity
+    shockwave   a disc of radius scale * half a fragment at its position, filled with its color
+                at its opacity, its edge bending the screen behind it (at most 12 at once)
+    zoom        the screen scaled by its scale around its position
 
-5. ANIMATION BEST PRACTICES:
-   - Use CCSequence::create() for sequential actions
-   - Use CCSpawn::create() for simultaneous actions  
-   - Always call CCRemoveSelf::create() at the end to clean up sprites
+DUAL MODE:
+Both players animate from their own death position, from one animation split between them:
+every emitter's fragments and particles alternate between the players, so dual mode costs the
+same fragments, batches and draw calls as a single death. Player emitters and single-fragment
+emitters go to both; tint, flash, vignette, zoom and overlays only play once.
+
+PRE-RENDERED (FLIPBOOK) PLAYBACK:
+With "Pre-rendered Animations" on, the fragments and particles drawn from the death position are
+rendered once per animation, frame size and frame rate into flipbooks/<name>-<tier>-<size>-<fps>.bin
+in the mod's save directory, on a worker thread the first time a level loads. New bests then play
+them as one quad; the player, overlays, screen effects and "column" fragments still play live.
+Deaths before the bake is done, and dual mode, play everything live.
+
+AVAILABLE STEPS:
+- Movement: { "moveTo": [x, y] }, { "moveBy": [x, y] }, { "jumpTo": [x, y], "height": 100 }
+- Scaling: { "scaleTo": 2 }
+- Rotation: { "rotateBy": 360 }
+- Color: { "tintTo": [r, g, b] }
+- Opacity: { "fadeIn": 0.5 }, { "fadeOut": 0.5 }, { "fadeTo": 150 }
+- Timing: { "wait": 1 }, { "after": 0.5 }, { "repeat": 4, "steps": [ ... ] }
+- Utility: "remove"
+Tweens take a "duration", and optionally an "ease" (in, out, inOut) with a "rate".
+
+ANIMATION BEST PRACTICES:
+   - Tweens on a fragment run side by side (like CCSpawn); wait moves on (like CCSequence)
+   - after delays just the next tween, for a CCDelayTime nested inside a CCSpawn
+   - A fragment only enters the scene when its first tween starts, a long wait costs nothing
+   - Always end a fragment with "remove" so its sprite returns to the pool
+   - Anything covering the whole screen should be an effect, not a huge fragment
    - Set appropriate Z-order values (higher = front layer)
-   - Use log::info() for debugging with descriptive messages
    - Respect the duration setting from mod configuration
 
-AVAILABLE COCOS2D ACTIONS:
-- Movement: CCMoveTo, CCMoveBy, CCJumpTo, CCJumpBy
-- Scaling: CCScaleTo, CCScaleBy
-- Rotation: CCRotateTo, CCRotateBy
-- Color: CCTintTo, CCTintBy
-- Opacity: CCFadeIn, CCFadeOut, CCFadeTo
-- Timing: CCDelayTime, CCRepeat
-- Easing: CCEaseIn, CCEaseOut, CCEaseInOut
-- Utility: CCRemoveSelf, CCCallFunc
-
 ===============================================================================================
 */
 
-// ===============================================================================================
-// ANIMATION 1: TELEPORTATION EXPLOSION - Interdimensional chaos with reality collapse
-
-void DeathAnimations::createExplosionAnimation(PlayLayer* playLayer, CCPoint playerPos) {
-    log::info("🎬 EXPLOSION ANIMATION - Epic death sequence at position ({}, {})", playerPos.x, playerPos.y);
+namespace {
+    MappedFile s_cacheFile;
+    std::vector<uint8_t> s_compiled;    // used in place when the cache could not be written
+    AnimationPack s_pack;
     
-    auto player1 = playLayer->m_player1;
-    auto player2 = playLayer->m_player2;
-    auto mainPlayer = player1 ? player1 : player2;
-    
-    if (!mainPlayer) {
-        log::warn("No player found for explosion animation");
-        return;
+    std::vector<std::filesystem::path> findDefinitions() {
+        std::vector<std::filesystem::path> paths;
+        std::error_code error;
+        for (auto const& entry : std::filesystem::directory_iterator(Mod::get()->getResourcesDir(), error)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                paths.push_back(entry.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
     }
     
-    if (mainPlayer) {
-        mainPlayer->stopAllActions();
-        mainPlayer->setColor(ccc3(255, 100, 100));
-        mainPlayer->setScale(1.0f);
+    // FNV-1a over the name, size and modification time of every definition,
+    // so checking the cache never has to read the definitions themselves
+    uint64_t fingerprint(std::vector<std::filesystem::path> const& paths) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        auto mix = [&hash](const void* data, size_t size) {
+            auto bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; i++) {
+                hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+            }
+        };
         
-        mainPlayer->runAction(CCSequence::create(
-            CCRepeat::create(
-                CCSequence::create(
-                    CCScaleTo::create(0.06f, 1.4f),
-                    CCScaleTo::create(0.06f, 0.9f),
-                    nullptr
-                ), 6
-            ),
-            CCDelayTime::create(0.2f),
-            CCSpawn::create(
-                CCEaseOut::create(CCMoveBy::create(0.6f, ccp(-200, 150)), 3.0f),
-                CCEaseInOut::create(CCScaleTo::create(0.6f, 2.2f), 2.0f),
-                CCTintTo::create(0.6f, 100, 255, 255),
-                nullptr
-            ),
-            CCSpawn::createWithTwoActions(
-                CCFadeOut::create(0.08f),
-                CCScaleTo::create(0.08f, 0.1f)
-            ),
-            CCDelayTime::create(0.25f),
-            CCSpawn::create(
-                CCFadeIn::create(0.15f),
-                CCScaleTo::create(0.15f, 1.8f),
-                CCMoveTo::create(0.15f, CCPoint(playerPos.x + 300, playerPos.y + 80)),
-                CCTintTo::create(0.15f, 255, 255, 100),
-                nullptr
-            ),
-            CCDelayTime::create(0.3f),
-            CCSpawn::create(
-                CCFadeOut::create(0.1f),
-                CCScaleTo::create(0.1f, 0.05f),
-                nullptr
-            ),
-            CCDelayTime::create(0.2f),
-            CCSpawn::create(
-                CCFadeIn::create(0.18f),
-                CCScaleTo::create(0.18f, 2.8f),
-                CCMoveTo::create(0.18f, CCPoint(playerPos.x - 150, playerPos.y - 100)),
-                CCTintTo::create(0.18f, 255, 100, 255),
-                nullptr
-            ),
-            CCDelayTime::create(0.35f),
-            CCSpawn::create(
-                CCFadeOut::create(0.08f),
-                CCScaleTo::create(0.08f, 0.02f),
-                nullptr
-            ),
-            CCDelayTime::create(0.15f),
-            CCSpawn::create(
-                CCFadeIn::create(0.2f),
-                CCScaleTo::create(0.2f, 3.5f),
-                CCMoveTo::create(0.2f, playerPos),
-                CCTintTo::create(0.2f, 255, 255, 255),
-                nullptr
-            ),
-            CCRepeat::create(
-                CCSequence::create(
-                    CCScaleTo::create(0.04f, 4.0f),
-                    CCScaleTo::create(0.04f, 3.0f),
-                    nullptr
-                ), 8
-            ),
-            CCSpawn::create(
-                CCEaseIn::create(CCScaleTo::create(0.8f, 0.0f), 4.0f),
-                CCSequence::create(
-                    CCTintTo::create(0.25f, 255, 0, 0),
-                    CCTintTo::create(0.25f, 0, 255, 0),
-                    CCTintTo::create(0.3f, 0, 0, 255),
-                    nullptr
-                ),
-                CCSequence::create(
-                    CCDelayTime::create(0.5f),
-                    CCFadeOut::create(0.3f),
-                    nullptr
-                ),
-                nullptr
-            ),
-            nullptr
-        ));
-    }
-    
-    for (int portal = 0; portal < 4; portal++) {
-        auto teleportPortal = CCSprite::create("GJ_square01.png");
-        if (teleportPortal) {
-            CCPoint portalPositions[4] = {
-                CCPoint(playerPos.x - 200, playerPos.y + 150),
-                CCPoint(playerPos.x + 300, playerPos.y + 80),
-                CCPoint(playerPos.x - 150, playerPos.y - 100),
-                playerPos
-            };
-            
-            teleportPortal->setPosition(portalPositions[portal]);
-            teleportPortal->setScale(0.0f);
-            teleportPortal->setColor(ccc3(100 + portal * 50, 255 - portal * 40, 255));
-            teleportPortal->setOpacity(0);
-            teleportPortal->setZOrder(2800 + portal * 10);
-            
-            teleportPortal->runAction(CCSequence::create(
-                CCDelayTime::create(1.0f + portal * 0.8f),
-                CCSpawn::create(
-                    CCFadeIn::create(0.2f),
-                    CCEaseOut::create(CCScaleTo::create(0.2f, 4.0f + portal * 0.8f), 2.0f),
-                    nullptr
-                ),
-                CCRepeat::create(
-                    CCSequence::create(
-                        CCScaleTo::create(0.08f, 5.0f + portal * 0.8f),
-                        CCScaleTo::create(0.08f, 3.5f + portal * 0.8f),
-                        nullptr
-                    ), 5
-                ),
-                CCSpawn::create(
-                    CCFadeOut::create(0.25f),
-                    CCScaleTo::create(0.25f, 0.0f),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(teleportPortal);
+        mix(&kAnimationPackVersion, sizeof(kAnimationPackVersion));
+        for (auto const& path : paths) {
+            std::error_code error;
+            auto name = path.filename().string();
+            uint64_t size = std::filesystem::file_size(path, error);
+            int64_t modified = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+            mix(name.data(), name.size());
+            mix(&size, sizeof(size));
+            mix(&modified, sizeof(modified));
         }
+        return hash;
     }
     
-    for (int timeWave = 0; timeWave < 6; timeWave++) {
-        auto timeCrack = CCSprite::create("GJ_square01.png");
-        if (timeCrack) {
-            timeCrack->setPosition(CCPoint(
-                playerPos.x + (rand() % 400 - 200),
-                playerPos.y + (rand() % 300 - 150)
-            ));
-            timeCrack->setScale(0.0f);
-            timeCrack->setColor(ccc3(255, 255 - timeWave * 30, 255 - timeWave * 40));
-            timeCrack->setOpacity(200);
-            timeCrack->setZOrder(2600);
-            timeCrack->setRotation(rand() % 360);
-            
-            timeCrack->runAction(CCSequence::create(
-                CCDelayTime::create(1.5f + timeWave * 0.2f),
-                CCSpawn::create(
-                    CCFadeIn::create(0.15f),
-                    CCEaseOut::create(CCScaleTo::create(0.6f, 8.0f), 3.0f),
-                    CCRotateBy::create(0.6f, 180 + rand() % 360),
-                    nullptr
-                ),
-                CCDelayTime::create(0.3f),
-                CCSpawn::create(
-                    CCFadeOut::create(0.4f),
-                    CCScaleTo::create(0.4f, 0.0f),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(timeCrack);
-        }
-    }
+    // What one tier of an animation holds at once, so a level can fill the pool without building it
+    struct TierInfo {
+        size_t fragments = 0;
+        size_t overlays = 0;
+        size_t layers = 0;
+        std::vector<size_t> bursts;     // particles in each
+    };
+    
+    struct Registered {
+        std::string name;
+        const PackedAnimation* animation;
+        float duration = 0.0f;          // at its own pace, before the delay scales it
+        std::array<TierInfo, 3> tiers;  // by Quality
+    };
+    std::vector<Registered> s_registry;
     
-    for (int fragment = 0; fragment < 25; fragment++) {
-        auto realityFragment = CCSprite::create("GJ_square01.png");
-        if (realityFragment) {
-            realityFragment->setPosition(CCPoint(
-                playerPos.x + (rand() % 500 - 250),
-                playerPos.y + (rand() % 400 - 200)
-            ));
-            realityFragment->setScale(0.1f + (rand() % 80) / 100.0f);
-            realityFragment->setColor(ccc3(255, 50 + rand() % 205, 100 + rand() % 155));
-            realityFragment->setZOrder(2400);
-            realityFragment->setOpacity(0);
-            realityFragment->setRotation(rand() % 360);
-            
-            float glitchDirection = (rand() % 2 == 0) ? 1.0f : -1.0f;
-            
-            realityFragment->runAction(CCSequence::create(
-                CCDelayTime::create(0.8f + (rand() % 120) / 100.0f),
-                CCSpawn::create(
-                    CCFadeIn::create(0.1f),
-                    CCScaleTo::create(0.1f, 1.2f + (rand() % 60) / 100.0f),
-                    nullptr
-                ),
-                CCRepeat::create(
-                    CCSequence::create(
-                        CCMoveBy::create(0.06f, ccp(glitchDirection * 20, 0)),
-                        CCMoveBy::create(0.06f, ccp(-glitchDirection * 20, 0)),
-                        CCMoveBy::create(0.06f, ccp(0, glitchDirection * 15)),
-                        CCMoveBy::create(0.06f, ccp(0, -glitchDirection * 15)),
-                        nullptr
-                    ), 8
-                ),
-                CCSpawn::create(
-                    CCEaseIn::create(CCMoveBy::create(1.0f, ccp(
-                        glitchDirection * (200 + rand() % 300),
-                        (rand() % 400 - 200)
-                    )), 3.0f),
-                    CCRotateBy::create(1.0f, glitchDirection * (720 + rand() % 1080)),
-                    CCSequence::create(
-                        CCDelayTime::create(0.5f),
-                        CCFadeOut::create(0.5f),
-                        nullptr
-                    ),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(realityFragment);
+    // One entry per animation in the pack, in the pack's file name order, with what a dry run of
+    // it builds on each tier. Counts don't depend on the screen, so a fixed one is used
+    void registerAnimations() {
+        s_registry.clear();
+        AnimationPack::Context context;
+        context.winWidth = 569.0f;
+        context.winHeight = 320.0f;
+        context.fragmentHeight = 40.0f;
+        
+        for (size_t i = 0; i < s_pack.getAnimationCount(); i++) {
+            auto animation = s_pack.getAnimation(i);
+            Registered entry = { animation->name, animation };
+            for (auto quality : { Quality::Low, Quality::Medium, Quality::High }) {
+                context.quality = quality;
+                Random random(Random::seedFor(0, 1));
+                TimelineBuilder builder;
+                s_pack.expand(*animation, context, random, builder);
+                auto timeline = builder.build();
+                
+                // Random delays move the peak around a little from one death to the next
+                auto& tier = entry.tiers[static_cast<size_t>(quality)];
+                tier.fragments = timeline.getPeakCount(Timeline::Target::Fragment);
+                tier.fragments += tier.fragments / 4;
+                tier.overlays = timeline.getPeakCount(Timeline::Target::Overlay);
+                tier.layers = timeline.getLayers().size();
+                for (auto const& burst : timeline.getBursts()) {
+                    tier.bursts.push_back(burst.size());
+                }
+                entry.duration = timeline.getDuration();
+            }
+            s_registry.push_back(std::move(entry));
         }
     }
+}
+
+// ===============================================================================================
+// DEFINITIONS - Map the compiled cache, or compile the JSON files and cache them
+
+void DeathAnimations::loadDefinitions() {
+    auto start = std::chrono::steady_clock::now();
+    auto paths = findDefinitions();
+    uint64_t sources = fingerprint(paths);
+    auto cachePath = Mod::get()->getSaveDir() / "animations.bin";
     
-    for (int vortex = 0; vortex < 3; vortex++) {
-        auto dimensionVortex = CCSprite::create("GJ_square01.png");
-        if (dimensionVortex) {
-            CCPoint vortexPositions[3] = {
-                CCPoint(playerPos.x - 180, playerPos.y + 120),
-                CCPoint(playerPos.x + 250, playerPos.y + 60),
-                CCPoint(playerPos.x - 100, playerPos.y - 80)
-            };
-            
-            dimensionVortex->setPosition(vortexPositions[vortex]);
-            dimensionVortex->setScale(0.0f);
-            dimensionVortex->setColor(ccc3(100 + vortex * 77, 50, 255 - vortex * 50));
-            dimensionVortex->setOpacity(150);
-            dimensionVortex->setZOrder(2200);
-            
-            dimensionVortex->runAction(CCSequence::create(
-                CCDelayTime::create(1.2f + vortex * 0.6f),
-                CCSpawn::create(
-                    CCFadeIn::create(0.3f),
-                    CCEaseOut::create(CCScaleTo::create(0.8f, 6.0f + vortex * 2.0f), 2.5f),
-                    nullptr
-                ),
-                CCRepeat::create(
-                    CCSequence::create(
-                        CCRotateBy::create(0.15f, 60),
-                        CCScaleTo::create(0.08f, 7.0f + vortex * 2.0f),
-                        CCScaleTo::create(0.08f, 5.5f + vortex * 2.0f),
-                        nullptr
-                    ), 6
-                ),
-                CCSpawn::create(
-                    CCFadeOut::create(0.5f),
-                    CCScaleTo::create(0.5f, 0.0f),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(dimensionVortex);
-        }
+    s_pack.detach();
+    s_cacheFile.close();
+    s_compiled.clear();
+    
+    if (s_cacheFile.open(cachePath) && s_pack.attach(s_cacheFile.data(), s_cacheFile.size()) && s_pack.getFingerprint() == sources) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        log::info("Mapped {} cached animations in {}us", s_pack.getAnimationCount(), elapsed.count());
+        registerAnimations();
+        return;
     }
+    s_pack.detach();
+    s_cacheFile.close();
     
-    for (int wave = 0; wave < 10; wave++) {
-        auto realityCollapseWave = CCSprite::create("GJ_square01.png");
-        if (realityCollapseWave) {
-            realityCollapseWave->setPosition(playerPos);
-            realityCollapseWave->setScale(0.1f);
-            realityCollapseWave->setColor(ccc3(255 - wave * 20, 100 + wave * 15, 255));
-            realityCollapseWave->setOpacity(180 - wave * 15);
-            realityCollapseWave->setZOrder(1900 - wave * 8);
-            
-            realityCollapseWave->runAction(CCSequence::create(
-                CCDelayTime::create(3.5f + wave * 0.05f),
-                CCSpawn::create(
-                    CCEaseOut::create(CCScaleTo::create(1.2f, 15.0f + wave * 4), 3.5f),
-                    CCSequence::create(
-                        CCDelayTime::create(0.4f),
-                        CCFadeOut::create(0.8f),
-                        nullptr
-                    ),
-                    CCSequence::create(
-                        CCTintTo::create(0.2f, 255, 255, 255),
-                        CCTintTo::create(0.2f, 100, 100, 255),
-                        CCTintTo::create(0.2f, 255, 100, 100),
-                        CCTintTo::create(0.6f, 255, 255, 255),
-                        nullptr
-                    ),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(realityCollapseWave);
+    AnimationCompiler compiler;
+    for (auto const& path : paths) {
+        auto json = file::readString(path);
+        if (!json) {
+            log::warn("Could not read animation {}: {}", path.filename().string(), json.unwrapErr());
+            continue;
+        }
+        auto result = compiler.add(path.stem().string(), json.unwrap());
+        if (!result) {
+            log::warn("Skipping animation {}: {}", path.filename().string(), result.unwrapErr());
         }
     }
+    s_compiled = compiler.finish(sources);
     
-    for (int i = 0; i < 60; i++) {
-        auto particle = CCSprite::create("GJ_square01.png");
-        if (particle) {
-            particle->setPosition(playerPos);
-            particle->setScale(0.2f + (rand() % 50) / 100.0f);
-            particle->setColor(ccc3(255, 100 + rand() % 155, 20 + rand() % 100));
-            particle->setZOrder(1800);
-            
-            float angle = (rand() % 360) * M_PI / 180.0f;
-            float speed = 100 + rand() % 200;
-            CCPoint targetPos = CCPoint(
-                playerPos.x + cos(angle) * speed,
-                playerPos.y + sin(angle) * speed
-            );
-            
-            particle->runAction(CCSequence::create(
-                CCDelayTime::create(2.5f + (rand() % 40) / 100.0f),
-                CCSpawn::create(
-                    CCEaseOut::create(CCMoveTo::create(1.8f, targetPos), 2.5f),
-                    CCRotateBy::create(1.8f, 540 + rand() % 720),
-                    CCSequence::create(
-                        CCDelayTime::create(0.8f),
-                        CCFadeOut::create(1.0f),
-                        nullptr
-                    ),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(particle);
-        }
+    // The cache is written before it is mapped, a mapped file can't be replaced on Windows
+    auto written = file::writeBinary(cachePath, s_compiled);
+    if (written && s_cacheFile.open(cachePath) && s_pack.attach(s_cacheFile.data(), s_cacheFile.size())) {
+        s_compiled.clear();
+        s_compiled.shrink_to_fit();
+    } else {
+        log::warn("Could not cache compiled animations, keeping them in memory");
+        s_cacheFile.close();
+        s_pack.attach(s_compiled.data(), s_compiled.size());
     }
     
-    for (int i = 0; i < 30; i++) {
-        auto sparkle = CCSprite::create("GJ_square01.png");
-        if (sparkle) {
-            sparkle->setPosition(CCPoint(
-                playerPos.x + (rand() % 300 - 150),
-                playerPos.y + (rand() % 150 - 75)
-            ));
-            sparkle->setScale(0.05f);
-            sparkle->setColor(ccc3(255, 255, 100 + rand() % 155));
-            sparkle->setZOrder(1700);
-            
-            sparkle->runAction(CCSequence::create(
-                CCDelayTime::create(4.0f + (rand() % 80) / 100.0f),
-                CCSpawn::createWithTwoActions(
-                    CCScaleTo::create(0.4f, 0.4f),
-                    CCFadeIn::create(0.4f)
-                ),
-                CCRepeat::create(
-                    CCSequence::create(
-                        CCScaleTo::create(0.1f, 0.5f),
-                        CCScaleTo::create(0.1f, 0.3f),
-                        nullptr
-                    ), 4
-                ),
-                CCSpawn::createWithTwoActions(
-                    CCFadeOut::create(0.6f),
-                    CCScaleTo::create(0.6f, 0.0f)
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(sparkle);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    log::info("Compiled {} animations in {}us", compiler.getAnimationCount(), elapsed.count());
+    registerAnimations();
+}
+
+// ===============================================================================================
+// REGISTRY - Animations by index, so nothing after loading looks one up by name
+
+size_t DeathAnimations::resolveAnimation(std::string_view name) {
+    size_t fallback = 0;
+    for (size_t i = 0; i < s_registry.size(); i++) {
+        if (s_registry[i].name == name) return i;
+        if (s_registry[i].name == "explosion") {
+            fallback = i;
         }
     }
+    log::warn("No animation definition named '{}', using {}", name, s_registry.empty() ? "none" : s_registry[fallback].name);
+    return fallback;
+}
+
+// ===============================================================================================
+// BENCHMARK - Build and step every animation without a level, results go to the log
+
+void DeathAnimations::runBenchmark(int iterations) {
+    // A typical 16:9 screen, with a player so nothing is skipped
+    AnimationPack::Context context;
+    context.winWidth = 569.0f;
+    context.winHeight = 320.0f;
+    context.fragmentHeight = 40.0f;
     
-    auto finalZoom = CCSprite::create("GJ_square01.png");
-    if (finalZoom) {
-        finalZoom->setPosition(playerPos);
-        finalZoom->setScale(0.0f);
-        finalZoom->setColor(ccc3(100, 50, 200));
-        finalZoom->setOpacity(100);
-        finalZoom->setZOrder(1600);
+    for (size_t i = 0; i < s_pack.getAnimationCount(); i++) {
+        auto animation = s_pack.getAnimation(i);
+        auto report = AnimationBenchmark::run([&]() {
+            Random random(Random::seedFor(0, 1));
+            TimelineBuilder timeline;
+            s_pack.expand(*animation, context, random, timeline);
+            return timeline.build();
+        }, iterations);
         
-        finalZoom->runAction(CCSequence::create(
-            CCDelayTime::create(4.8f),
-            CCSpawn::createWithTwoActions(
-                CCEaseOut::create(CCScaleTo::create(0.2f, 20.0f), 4.0f),
-                CCFadeOut::create(0.2f)
-            ),
-            CCRemoveSelf::create(),
-            nullptr
-        ));
+        log::info("Benchmark {}: built in {:.1f}us, {} fragments, {} particles, {} nodes ({} live at peak), {} keys, {} KiB, {:.2f}s",
+            animation->name, report.buildMicroseconds, report.fragments, report.particles, report.nodes, report.peakLiveNodes,
+            report.keys, report.memoryBytes / 1024, report.duration
+        );
+        for (auto const& frames : report.frames) {
+            log::info("Benchmark {} @ {} Hz: {} frames, {:.2f}us average, {:.2f}us worst ({:.2f}% of the frame budget)",
+                animation->name, frames.refreshRate, frames.frames,
+                frames.averageMicroseconds, frames.worstMicroseconds, frames.budgetPercent
+            );
+        }
         
-        playLayer->addChild(finalZoom);
+        // Against the small flipbook, baked with a plain square so it runs the same anywhere
+        Random random(Random::seedFor(0, 1));
+        TimelineBuilder builder;
+        s_pack.expand(*animation, context, random, builder);
+        auto flipbook = AnimationBenchmark::compareFlipbook(builder.build(), Flipbook::Stamp::square(32, context.fragmentHeight), { 192, 24.0f });
+        log::info("Benchmark {} flipbook: baked in {:.1f}ms, {} frames of {}x{}, {} KiB texture, {} KiB on disk, {:.2f}us of timeline per frame live, {:.2f}us next to the flipbook ({} fragments left live)",
+            animation->name, flipbook.bakeMilliseconds, flipbook.frames, flipbook.frameWidth, flipbook.frameHeight,
+            flipbook.textureBytes / 1024, flipbook.diskBytes / 1024, flipbook.liveMicroseconds, flipbook.flipbookMicroseconds, flipbook.liveFragments
+        );
+    }
+    
+    for (int rate : AnimationBenchmark::kRefreshRates) {
+        auto ghost = AnimationBenchmark::recordGhost(rate);
+        log::info("Benchmark ghost @ {} Hz: {:.1f}ns per frame, {} KiB per minute, ring of {} KiB holds {:.0f}s, last 10s decoded in {:.1f}us, {:.3f} units off at worst",
+            rate, ghost.recordNanoseconds, ghost.bytesPerMinute / 1024, GhostRecorder::getMemoryUsage() / 1024,
+            ghost.ringSeconds, ghost.extractMicroseconds, ghost.worstError
+        );
     }
 }
 
 // ===============================================================================================
-// ANIMATION 2: HEAVENLY ASCENSION - Divine ascension with dramatic fall
+// FLIPBOOKS - Bake the selected animation once, or read the bake back, and upload it
 
-void DeathAnimations::createAscensionAnimation(PlayLayer* playLayer, CCPoint playerPos) {
-    log::info("✨ ASCENSION ANIMATION - Epic rise and fall sequence at position ({}, {})", playerPos.x, playerPos.y);
+namespace {
+    // Shared with the baker, which may outlive the level that asked for it
+    struct FlipbookBake {
+        Flipbook flipbook;
+        std::atomic<bool> done = false;
+    };
     
-    auto player1 = playLayer->m_player1;
-    auto player2 = playLayer->m_player2;
-    auto mainPlayer = player1 ? player1 : player2;
+    // What a bake was made for, compared on every new best, so it is kept to plain values
+    struct FlipbookKey {
+        size_t animation = 0;
+        Quality quality = Quality::High;
+        uint32_t size = 0;
+        float fps = 0.0f;
+        
+        bool operator==(FlipbookKey const&) const = default;
+    };
     
-    if (!mainPlayer) {
-        log::warn("No player found for ascension animation");
-        return;
-    }
+    std::optional<FlipbookKey> s_flipbookKey;
+    std::shared_ptr<FlipbookBake> s_flipbookBake;
+    Flipbook s_flipbook;                    // layout only, its pixels live in the texture
+    Ref<CCTexture2D> s_flipbookTexture;
     
-    if (mainPlayer) {
-        mainPlayer->stopAllActions();
-        mainPlayer->setColor(ccc3(255, 255, 200));
-        mainPlayer->setScale(1.0f);
-        
-        mainPlayer->runAction(CCSequence::create(
-            CCSpawn::create(
-                CCEaseInOut::create(CCMoveBy::create(0.8f, ccp(0, 20)), 2.0f),
-                CCSequence::create(
-                    CCScaleTo::create(0.4f, 1.3f),
-                    CCScaleTo::create(0.4f, 1.0f),
-                    nullptr
-                ),
-                CCTintTo::create(0.8f, 255, 255, 255),
-                nullptr
-            ),
-            CCDelayTime::create(0.2f),
-            CCSpawn::create(
-                CCEaseOut::create(CCMoveBy::create(2.5f, ccp(0, 400)), 2.0f),
-                CCRotateBy::create(2.5f, 360.0f),
-                CCSequence::create(
-                    CCScaleTo::create(1.0f, 1.8f),
-                    CCScaleTo::create(1.5f, 1.2f),
-                    nullptr
-                ),
-                CCSequence::create(
-                    CCTintTo::create(1.0f, 255, 255, 100),
-                    CCTintTo::create(1.5f, 255, 255, 255),
-                    nullptr
-                ),
-                nullptr
-            ),
-            CCDelayTime::create(0.3f),
-            CCSpawn::create(
-                CCEaseIn::create(CCMoveBy::create(1.5f, ccp(0, -500)), 4.0f),
-                CCRotateBy::create(1.5f, 1440.0f),
-                CCSequence::create(
-                    CCScaleTo::create(0.5f, 0.8f),
-                    CCScaleTo::create(0.5f, 1.5f),
-                    CCScaleTo::create(0.5f, 0.3f),
-                    nullptr
-                ),
-                CCSequence::create(
-                    CCTintTo::create(0.3f, 255, 100, 100),
-                    CCTintTo::create(0.6f, 100, 100, 255),
-                    CCTintTo::create(0.6f, 255, 255, 255),
-                    nullptr
-                ),
-                nullptr
-            ),
-            CCSpawn::createWithTwoActions(
-                CCScaleTo::create(0.2f, 0.0f),
-                CCFadeOut::create(0.2f)
-            ),
-            nullptr
-        ));
+    // Grind mode keeps to the low tier; otherwise the flipbook costs the same at any tier
+    Quality flipbookQuality() {
+        return Config::get().grind ? Quality::Low : Quality::High;
     }
     
-    for (int wing = 0; wing < 2; wing++) {
-        for (int feather = 0; feather < 8; feather++) {
-            auto wingFeather = CCSprite::create("GJ_square01.png");
-            if (wingFeather) {
-                float side = wing == 0 ? -1.0f : 1.0f;
-                float wingAngle = side * (20 + feather * 12);
-                float distance = 50 + feather * 15;
-                
-                CCPoint featherPos = CCPoint(
-                    playerPos.x + side * distance * cos(wingAngle * M_PI / 180.0f),
-                    playerPos.y + distance * sin(wingAngle * M_PI / 180.0f)
-                );
-                
-                wingFeather->setPosition(featherPos);
-                wingFeather->setScale(0.0f);
-                wingFeather->setColor(ccc3(255, 255, 200 + feather * 5));
-                wingFeather->setOpacity(200);
-                wingFeather->setZOrder(2700);
-                wingFeather->setRotation(wingAngle);
-                
-                wingFeather->runAction(CCSequence::create(
-                    CCDelayTime::create(0.5f + feather * 0.08f),
-                    CCSpawn::create(
-                        CCScaleTo::create(0.4f, 2.0f + feather * 0.3f),
-                        CCFadeIn::create(0.4f),
-                        CCRotateBy::create(0.4f, side * 30),
-                        nullptr
-                    ),
-                    CCSpawn::create(
-                        CCMoveBy::create(2.0f, ccp(0, 200 + feather * 20)),
-                        CCRotateBy::create(2.0f, side * 180),
-                        nullptr
-                    ),
-                    CCSpawn::create(
-                        CCMoveBy::create(1.5f, ccp(side * 100, -300)),
-                        CCRotateBy::create(1.5f, side * 360),
-                        CCFadeOut::create(1.5f),
-                        nullptr
-                    ),
-                    CCRemoveSelf::create(),
-                    nullptr
-                ));
-                
-                playLayer->addChild(wingFeather);
-            }
-        }
+    FlipbookKey flipbookKey(size_t animation, Quality quality) {
+        auto const& config = Config::get();
+        return { animation, quality, config.flipbookSize, config.flipbookFps };
     }
     
-    auto lightPillar = CCSprite::create("GJ_square01.png");
-    if (lightPillar) {
-        auto winSize = CCDirector::get()->getWinSize();
-        lightPillar->setPosition(CCPoint(playerPos.x, winSize.height / 2));
-        lightPillar->setScaleX(3.0f);
-        lightPillar->setScaleY(winSize.height / lightPillar->getContentSize().height);
-        lightPillar->setColor(ccc3(255, 255, 150));
-        lightPillar->setOpacity(0);
-        lightPillar->setZOrder(2600);
-        
-        lightPillar->runAction(CCSequence::create(
-            CCDelayTime::create(1.0f),
-            CCFadeTo::create(0.8f, 150),
-            CCDelayTime::create(2.0f),
-            CCFadeOut::create(1.2f),
-            CCRemoveSelf::create(),
-            nullptr
-        ));
-        
-        playLayer->addChild(lightPillar);
+    std::string flipbookName(FlipbookKey const& key) {
+        return fmt::format("{}-{}-{}-{}", s_registry[key.animation].name, static_cast<int>(key.quality), key.size, key.fps);
     }
     
-    for (int i = 0; i < 20; i++) {
-        auto musicalNote = CCSprite::create("GJ_square01.png");
-        if (musicalNote) {
-            musicalNote->setPosition(CCPoint(
-                playerPos.x + (rand() % 400 - 200),
-                playerPos.y + (rand() % 150 - 75)
-            ));
-            musicalNote->setScale(0.1f + (rand() % 40) / 100.0f);
-            musicalNote->setColor(ccc3(255, 255, 150 + rand() % 105));
-            musicalNote->setZOrder(2500);
-            musicalNote->setOpacity(0);
-            
-            float floatDirection = (rand() % 2 == 0) ? 1.0f : -1.0f;
-            
-            musicalNote->runAction(CCSequence::create(
-                CCDelayTime::create(1.5f + (rand() % 150) / 100.0f),
-                CCFadeIn::create(0.4f),
-                CCSpawn::create(
-                    CCEaseInOut::create(CCMoveBy::create(2.5f, ccp(floatDirection * 80, 250)), 2.0f),
-                    CCRotateBy::create(2.5f, floatDirection * 360),
-                    CCSequence::create(
-                        CCDelayTime::create(1.5f),
-                        CCFadeOut::create(1.0f),
-                        nullptr
-                    ),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(musicalNote);
+    // The fragment texture itself, so a flipbook looks like the fragments it replaces
+    Flipbook::Stamp loadStamp(AnimationLayer* layer) {
+        auto size = layer->getPool().getFragmentSize();
+        CCImage image;
+        auto path = CCFileUtils::sharedFileUtils()->fullPathForFilename("GJ_square01.png", false);
+        if (image.initWithImageFile(path.c_str()) && image.hasAlpha() && image.getBitsPerComponent() == 8) {
+            Flipbook::Stamp stamp;
+            stamp.width = image.getWidth();
+            stamp.height = image.getHeight();
+            stamp.unitWidth = size.width;
+            stamp.unitHeight = size.height;
+            stamp.pixels.assign(image.getData(), image.getData() + static_cast<size_t>(stamp.width) * stamp.height * 4);
+            return stamp;
         }
+        log::warn("Could not read the fragment texture, baking flipbooks with a plain square");
+        return Flipbook::Stamp::square(32, size.height);
     }
     
-    for (int halo = 0; halo < 5; halo++) {
-        auto angelHalo = CCSprite::create("GJ_square01.png");
-        if (angelHalo) {
-            angelHalo->setPosition(CCPoint(playerPos.x, playerPos.y - 80));
-            angelHalo->setScale(0.1f);
-            angelHalo->setColor(ccc3(255, 255, 80 + halo * 20));
-            angelHalo->setOpacity(180);
-            angelHalo->setZOrder(2400);
-            
-            angelHalo->runAction(CCSequence::create(
-                CCDelayTime::create(2.0f + halo * 0.2f),
-                CCSpawn::create(
-                    CCEaseOut::create(CCScaleTo::create(2.0f, 4.0f + halo * 0.8f), 2.0f),
-                    CCEaseOut::create(CCMoveBy::create(2.0f, ccp(0, 300 + halo * 80)), 2.0f),
-                    CCSequence::create(
-                        CCDelayTime::create(1.0f),
-                        CCFadeOut::create(1.0f),
-                        nullptr
-                    ),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(angelHalo);
-        }
+    void requestFlipbook(size_t animation, AnimationLayer* layer) {
+        auto const& config = Config::get();
+        if (config.flipbookSize == 0) return;
+        auto key = flipbookKey(animation, flipbookQuality());
+        if (key == s_flipbookKey) return;
+        
+        s_flipbookKey = key;
+        s_flipbook = Flipbook();
+        s_flipbookTexture = nullptr;
+        s_flipbookBake = std::make_shared<FlipbookBake>();
+        
+        // Single player at its own pace, the same on every death
+        auto winSize = CCDirector::get()->getWinSize();
+        AnimationPack::Context context;
+        context.winWidth = winSize.width;
+        context.winHeight = winSize.height;
+        context.fragmentHeight = layer->getPool().getFragmentSize().height;
+        context.quality = flipbookQuality();
+        
+        auto stamp = loadStamp(layer);
+        uint64_t fingerprint = s_pack.getFingerprint() ^ (static_cast<uint64_t>(stamp.width) << 48 | static_cast<uint64_t>(stamp.height) << 32);
+        Flipbook::Settings settings = { config.flipbookSize, config.flipbookFps };
+        auto path = Mod::get()->getSaveDir() / "flipbooks" / fmt::format("{}.bin", flipbookName(key));
+        std::thread([bake = s_flipbookBake, packed = s_registry[animation].animation, context, stamp = std::move(stamp), fingerprint, settings, path]() {
+            bake->flipbook = Flipbook::load(path, fingerprint);
+            if (bake->flipbook.empty()) {
+                Random random(Random::seedFor(0, 1));
+                TimelineBuilder builder;
+                s_pack.expand(*packed, context, random, builder);
+                bake->flipbook = Flipbook::bake(builder.build(), context.quality, stamp, settings);
+                if (!bake->flipbook.empty()) {
+                    bake->flipbook.save(path, fingerprint);
+                }
+            }
+            bake->done = true;
+        }).detach();
     }
     
-    for (int i = 0; i < 40; i++) {
-        auto blessingStar = CCSprite::create("GJ_square01.png");
-        if (blessingStar) {
-            blessingStar->setPosition(CCPoint(
-                playerPos.x + (rand() % 600 - 300),
-                playerPos.y + (rand() % 300 - 150)
-            ));
-            blessingStar->setScale(0.05f);
-            blessingStar->setColor(ccc3(255, 255, 200 + rand() % 55));
-            blessingStar->setZOrder(2300);
-            blessingStar->setOpacity(0);
-            
-            blessingStar->runAction(CCSequence::create(
-                CCDelayTime::create(3.5f + (rand() % 120) / 100.0f),
-                CCSpawn::create(
-                    CCFadeIn::create(0.3f),
-                    CCScaleTo::create(0.3f, 0.6f),
-                    nullptr
-                ),
-                CCRepeat::create(
-                    CCSequence::create(
-                        CCScaleTo::create(0.15f, 0.8f),
-                        CCScaleTo::create(0.15f, 0.4f),
-                        nullptr
-                    ), 4
-                ),
-                CCSpawn::createWithTwoActions(
-                    CCFadeOut::create(0.8f),
-                    CCScaleTo::create(0.8f, 0.0f)
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(blessingStar);
-        }
+    // Only what was already uploaded counts, the new best never waits on or uploads a bake
+    bool flipbookReady(size_t animation, Quality quality) {
+        return s_flipbookTexture && s_flipbookKey == flipbookKey(animation, quality);
     }
+}
+
+void DeathAnimations::updateFlipbook() {
+    if (!s_flipbookBake || !s_flipbookBake->done) return;
+    s_flipbook = std::move(s_flipbookBake->flipbook);
+    s_flipbookBake.reset();
+    if (s_flipbook.empty()) return;
     
-    log::info("👼 ASCENSION COMPLETE: Player ascended to heaven and fell dramatically!");
+    auto texture = new CCTexture2D();
+    texture->initWithData(s_flipbook.getPixels(), kCCTexture2DPixelFormat_RGBA4444,
+        s_flipbook.getAtlasWidth(), s_flipbook.getAtlasHeight(), CCSize(s_flipbook.getAtlasWidth(), s_flipbook.getAtlasHeight())
+    );
+    texture->autorelease();
+    s_flipbookTexture = texture;
+    s_flipbook.releasePixels();
+    log::info("Flipbook {}: {} frames of {}x{}, {} KiB texture", flipbookName(*s_flipbookKey),
+        s_flipbook.getFrameCount(), s_flipbook.getFrameWidth(), s_flipbook.getFrameHeight(), s_flipbook.getMemoryUsage() / 1024
+    );
+}
+
+void DeathAnimations::releaseFlipbook() {
+    // A bake still running finishes into its own copy and is dropped with it
+    s_flipbookKey.reset();
+    s_flipbookBake.reset();
+    s_flipbook = Flipbook();
+    s_flipbookTexture = nullptr;
 }
 
 // ===============================================================================================
-// ANIMATION 3: SLAUGHTERHOUSE BRUTALITY - Ultra-violent, cinematic death sequence
-// Duration: 3 seconds | Style: Slaughterhouse-level intensity, maximum violence and drama
+// PRE-WARM - Fill the pool for the selected animation when the level loads
 
-void DeathAnimations::createSlaughterhouseAnimation(PlayLayer* playLayer, CCPoint playerPos) {
-    log::info("💀 SLAUGHTERHOUSE ANIMATION - BRUTAL death sequence at position ({}, {})", playerPos.x, playerPos.y);
-    
-    auto player1 = playLayer->m_player1;
-    auto player2 = playLayer->m_player2;
-    auto mainPlayer = player1 ? player1 : player2;
+void DeathAnimations::prewarm(AnimationLayer* layer) {
+    auto start = std::chrono::steady_clock::now();
+    if (s_registry.empty()) return;
+    auto const& config = Config::get();
+    auto const& entry = s_registry[config.animation];
     
-    if (!mainPlayer) {
-        log::warn("No player found for slaughterhouse animation");
-        return;
+    // Adaptive quality only steps down from the configured tier, the flipbook's may be above it
+    auto quality = config.getQuality();
+    if (config.flipbookSize) {
+        quality = std::max(quality, flipbookQuality());
     }
+    auto const& tier = entry.tiers[static_cast<size_t>(quality)];
+    auto& pool = layer->getPool();
+    pool.warm(tier.fragments, tier.layers, tier.overlays);
+    pool.warmAtlases(tier.bursts);
     
-    if (mainPlayer) {
-        mainPlayer->stopAllActions();
-        mainPlayer->setColor(ccc3(255, 255, 255));
-        mainPlayer->setScale(1.0f);
-        
-        mainPlayer->runAction(CCSequence::create(
-            CCRepeat::create(
-                CCSequence::create(
-                    CCMoveBy::create(0.02f, ccp(5, 0)),
-                    CCMoveBy::create(0.02f, ccp(-10, 0)),
-                    CCMoveBy::create(0.02f, ccp(5, 0)),
-                    nullptr
-                ), 8
-            ),
-            CCSpawn::create(
-                CCTintTo::create(0.1f, 255, 0, 0),
-                CCScaleTo::create(0.1f, 1.8f),
-                nullptr
-            ),
-            CCRepeat::create(
-                CCSequence::create(
-                    CCMoveBy::create(0.01f, ccp(15, 0)),
-                    CCMoveBy::create(0.01f, ccp(-15, 0)),
-                    CCMoveBy::create(0.01f, ccp(0, 10)),
-                    CCMoveBy::create(0.01f, ccp(0, -10)),
-                    nullptr
-                ), 20
-            ),
-            CCSpawn::create(
-                CCEaseIn::create(CCScaleTo::create(0.3f, 3.5f), 4.0f),
-                CCTintTo::create(0.3f, 150, 0, 0),
-                CCRotateBy::create(0.3f, 180),
-                nullptr
-            ),
-            CCRepeat::create(
-                CCSequence::create(
-                    CCMoveBy::create(0.005f, ccp(25, 0)),
-                    CCMoveBy::create(0.005f, ccp(-25, 0)),
-                    CCMoveBy::create(0.005f, ccp(0, 20)),
-                    CCMoveBy::create(0.005f, ccp(0, -20)),
-                    nullptr
-                ), 40
-            ),
-            CCSpawn::create(
-                CCEaseIn::create(CCScaleTo::create(0.4f, 0.1f), 5.0f),
-                CCTintTo::create(0.4f, 100, 0, 0),
-                CCRotateBy::create(0.4f, 720),
-                CCSequence::create(
-                    CCDelayTime::create(0.2f),
-                    CCFadeOut::create(0.2f),
-                    nullptr
-                ),
-                nullptr
-            ),
-            nullptr
-        ));
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    log::info("Pre-warmed {} animation in {}us: {} fragments, {} batches, {} overlays, {} particle atlases ({} allocations in total)",
+        entry.name, elapsed.count(), tier.fragments, tier.layers, tier.overlays, tier.bursts.size(), pool.getAllocationCount()
+    );
+    if (entry.duration > config.getDelay() * 2.0f) {
+        log::info("The {:.2f}s delay plays {} {:.1f}x faster than its {:.2f}s", config.getDelay(), entry.name, entry.duration / config.getDelay(), entry.duration);
     }
     
-    for (int splatter = 0; splatter < 40; splatter++) {
-        auto bloodSplatter = CCSprite::create("GJ_square01.png");
-        if (bloodSplatter) {
-            bloodSplatter->setPosition(playerPos);
-            bloodSplatter->setScale(0.3f + (rand() % 100) / 100.0f);
-            bloodSplatter->setColor(ccc3(200 + rand() % 55, rand() % 50, rand() % 30));
-            bloodSplatter->setZOrder(2900);
-            bloodSplatter->setOpacity(255);
-            
-            float explosionAngle = (rand() % 360) * M_PI / 180.0f;
-            float explosionSpeed = 200 + rand() % 400;
-            CCPoint targetPos = CCPoint(
-                playerPos.x + cos(explosionAngle) * explosionSpeed,
-                playerPos.y + sin(explosionAngle) * explosionSpeed
-            );
-            
-            bloodSplatter->runAction(CCSequence::create(
-                CCDelayTime::create(0.5f + (rand() % 20) / 100.0f),
-                CCSpawn::create(
-                    CCEaseOut::create(CCMoveTo::create(0.8f, targetPos), 3.0f),
-                    CCRotateBy::create(0.8f, 1080 + rand() % 1440),
-                    CCSequence::create(
-                        CCScaleTo::create(0.2f, 1.5f + (rand() % 100) / 100.0f),
-                        CCScaleTo::create(0.6f, 0.2f),
-                        nullptr
-                    ),
-                    CCSequence::create(
-                        CCDelayTime::create(0.4f),
-                        CCFadeOut::create(0.4f),
-                        nullptr
-                    ),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(bloodSplatter);
-        }
-    }
+    requestFlipbook(Config::get().animation, layer);
+}
+
+// ===============================================================================================
+// ANIMATION SELECTOR - Play the animation picked in the mod settings
+
+std::optional<DeathAnimations::Prepared> DeathAnimations::prepareAnimation(size_t animation, PlayLayer* playLayer, AnimationLayer* layer) {
+    if (animation >= s_registry.size()) return std::nullopt;
+    auto const& config = Config::get();
     
-    for (int gore = 0; gore < 15; gore++) {
-        auto goreChunk = CCSprite::create("GJ_square01.png");
-        if (goreChunk) {
-            goreChunk->setPosition(CCPoint(
-                playerPos.x + (rand() % 60 - 30),
-                playerPos.y + (rand() % 60 - 30)
-            ));
-            goreChunk->setScale(0.8f + (rand() % 80) / 100.0f);
-            goreChunk->setColor(ccc3(180 + rand() % 75, rand() % 30, rand() % 20));
-            goreChunk->setZOrder(2800);
-            goreChunk->setOpacity(255);
-            
-            float chunkAngle = (rand() % 360) * M_PI / 180.0f;
-            float chunkSpeed = 150 + rand() % 300;
-            CCPoint chunkTarget = CCPoint(
-                playerPos.x + cos(chunkAngle) * chunkSpeed,
-                playerPos.y + sin(chunkAngle) * chunkSpeed - 100
-            );
-            
-            goreChunk->runAction(CCSequence::create(
-                CCDelayTime::create(0.4f + gore * 0.02f),
-                CCSpawn::create(
-                    CCJumpTo::create(1.2f, chunkTarget, 80 + rand() % 120, 1),
-                    CCRotateBy::create(1.2f, 720 + rand() % 1080),
-                    CCSequence::create(
-                        CCDelayTime::create(0.6f),
-                        CCFadeOut::create(0.6f),
-                        nullptr
-                    ),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(goreChunk);
-        }
-    }
+    auto winSize = CCDirector::get()->getWinSize();
+    AnimationPack::Context context;
+    context.winWidth = winSize.width;
+    context.winHeight = winSize.height;
+    context.fragmentHeight = layer->getPool().getFragmentSize().height;
+    context.hasPlayer = playLayer->m_player1 || playLayer->m_player2;
+    context.players = playLayer->m_gameState.m_isDualMode && playLayer->m_player2 ? 2 : 1;
     
-    auto bloodOverlay = CCLayerColor::create(ccc4(150, 0, 0, 0));
-    bloodOverlay->setContentSize(CCDirector::get()->getWinSize());
-    bloodOverlay->setPosition(CCPointZero);
-    bloodOverlay->setZOrder(2700);
-    bloodOverlay->runAction(CCSequence::create(
-        CCDelayTime::create(0.5f),
-        CCFadeTo::create(0.1f, 180),
-        CCRepeat::create(
-            CCSequence::create(
-                CCFadeTo::create(0.05f, 220),
-                CCFadeTo::create(0.05f, 140),
-                nullptr
-            ), 15
-        ),
-        CCFadeTo::create(0.8f, 0),
-        CCRemoveSelf::create(),
-        nullptr
-    ));
-    playLayer->addChild(bloodOverlay);
+    // Auto starts from the tier the last animation settled on and only steps down from there
+    Prepared prepared;
+    prepared.adaptive = config.adaptiveQuality && !config.grind;
+    context.quality = config.getQuality();
+    if (context.players == 1 && flipbookReady(animation, flipbookQuality())) {
+        context.quality = flipbookQuality();
+        prepared.adaptive = false;
+        prepared.flipbook = true;
+    }
     
-    for (int shockwave = 0; shockwave < 8; shockwave++) {
-        auto violentShockwave = CCSprite::create("GJ_square01.png");
-        if (violentShockwave) {
-            violentShockwave->setPosition(playerPos);
-            violentShockwave->setScale(0.2f);
-            violentShockwave->setColor(ccc3(255, 50, 50));
-            violentShockwave->setOpacity(200);
-            violentShockwave->setZOrder(2600 - shockwave * 5);
-            
-            violentShockwave->runAction(CCSequence::create(
-                CCDelayTime::create(0.6f + shockwave * 0.08f),
-                CCSpawn::create(
-                    CCEaseOut::create(CCScaleTo::create(0.5f, 20.0f + shockwave * 8), 4.0f),
-                    CCSequence::create(
-                        CCTintTo::create(0.1f, 255, 0, 0),
-                        CCTintTo::create(0.1f, 100, 0, 0),
-                        CCTintTo::create(0.3f, 50, 0, 0),
-                        nullptr
-                    ),
-                    CCFadeOut::create(0.5f),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(violentShockwave);
-        }
+    // Seeded by level and attempt, so the same death always plays back the same way
+    Trace::begin(TraceEvent::Prepare, 0.0f, 0.0f, context.players);
+    Random random(Random::seedFor(playLayer->m_level->m_levelID.value(), playLayer->m_attempts));
+    TimelineBuilder timeline;
+    if (!s_pack.expand(*s_registry[animation].animation, context, random, timeline)) {
+        Trace::end(TraceEvent::Prepare);
+        log::warn("No player found for {} animation", s_registry[animation].name);
+        return std::nullopt;
     }
+    prepared.timeline = timeline.build();
+    // Authored at its own pace, played in whatever the delay leaves it
+    prepared.duration = config.getDelay();
+    prepared.timeline.scaleTo(prepared.duration);
+    Trace::end(TraceEvent::Prepare, 0.0f, 0.0f, static_cast<int32_t>(prepared.timeline.getFragments().size()));
     
-    for (int distortion = 0; distortion < 20; distortion++) {
-        auto screenDistortion = CCSprite::create("GJ_square01.png");
-        if (screenDistortion) {
-            screenDistortion->setPosition(CCPoint(
-                playerPos.x + (rand() % 600 - 300),
-                playerPos.y + (rand() % 400 - 200)
-            ));
-            screenDistortion->setScale(0.0f);
-            screenDistortion->setColor(ccc3(255, rand() % 100, rand() % 100));
-            screenDistortion->setZOrder(2500);
-            screenDistortion->setOpacity(150);
-            
-            screenDistortion->runAction(CCSequence::create(
-                CCDelayTime::create(0.8f + (rand() % 40) / 100.0f),
-                CCSpawn::create(
-                    CCScaleTo::create(0.1f, 3.0f + (rand() % 200) / 100.0f),
-                    CCFadeIn::create(0.1f),
-                    nullptr
-                ),
-                CCRepeat::create(
-                    CCSequence::create(
-                        CCScaleTo::create(0.02f, 4.0f),
-                        CCScaleTo::create(0.02f, 2.0f),
-                        nullptr
-                    ), 25
-                ),
-                CCSpawn::create(
-                    CCFadeOut::create(0.3f),
-                    CCScaleTo::create(0.3f, 0.0f),
-                    nullptr
-                ),
-                CCRemoveSelf::create(),
-                nullptr
-            ));
-            
-            playLayer->addChild(screenDistortion);
+    prepared.animation = animation;
+    prepared.players = context.players;
+    prepared.attempt = playLayer->m_attempts;
+    prepared.quality = context.quality;
+    return prepared;
+}
+
+std::optional<DeathAnimations::Prepared> DeathAnimations::prepareSelectedAnimation(PlayLayer* playLayer, AnimationLayer* layer) {
+    return prepareAnimation(Config::get().animation, playLayer, layer);
+}
+
+AnimationRunner* DeathAnimations::startAnimation(Prepared&& prepared, PlayLayer* playLayer, std::vector<CCPoint> const& origins, AnimationLayer* layer) {
+    Trace::begin(TraceEvent::Spawn, origins.front().x, origins.front().y);
+    if (prepared.flipbook && origins.size() == 1 && s_flipbookTexture) {
+        if (auto node = FlipbookNode::create(playLayer, s_flipbookTexture, s_flipbook, layer->toLayerSpace(origins.front()), prepared.timeline.getDuration())) {
+            layer->addChild(node, s_flipbook.getZOrder());
+            Flipbook::removeCovered(prepared.timeline);
         }
     }
-    
-    auto finalCarnage = CCSprite::create("GJ_square01.png");
-    if (finalCarnage) {
-        finalCarnage->setPosition(playerPos);
-        finalCarnage->setScale(0.0f);
-        finalCarnage->setColor(ccc3(100, 0, 0));
-        finalCarnage->setOpacity(200);
-        finalCarnage->setZOrder(2400);
-        
-        finalCarnage->runAction(CCSequence::create(
-            CCDelayTime::create(2.5f),
-            CCSpawn::create(
-                CCEaseOut::create(CCScaleTo::create(0.5f, 25.0f), 5.0f),
-                CCSequence::create(
-                    CCTintTo::create(0.1f, 200, 0, 0),
-                    CCTintTo::create(0.1f, 50, 0, 0),
-                    CCTintTo::create(0.3f, 0, 0, 0),
-                    nullptr
-                ),
-                CCFadeOut::create(0.5f),
-                nullptr
-            ),
-            CCRemoveSelf::create(),
-            nullptr
-        ));
-        
-        playLayer->addChild(finalCarnage);
+    auto runner = AnimationRunner::create(playLayer, layer, std::move(prepared.timeline), origins, prepared.quality);
+    Trace::end(TraceEvent::Spawn, 0.0f, 0.0f, runner ? static_cast<int32_t>(runner->getActiveCount()) : 0);
+    if (!runner) return nullptr;
+    if (prepared.adaptive) {
+        runner->setAdaptiveQuality(true);
+        runner->setFinishCallback([runner]() {
+            Config::setAutoQuality(runner->getSuggestedQuality());
+        });
     }
-    
-    log::info("💀 SLAUGHTERHOUSE COMPLETE: Player has been BRUTALLY destroyed!");
+    return runner;
 }
-// ===============================================================================================
-// ANIMATION SELECTOR - Choose which animation to play based on mod settings
-// Add new animations here by:
-// 1. Create your animation function above (follow the format)
-// 2. Add the animation name to mod.json settings
-// 3. Add the condition below to call your function
-// ===============================================================================================
 
-void DeathAnimations::createSelectedAnimation(PlayLayer* playLayer, CCPoint playerPos) {
-    std::string animationType = Mod::get()->getSettingValue<std::string>("animation-type");
-    
-    if (animationType == "ascension") {
-        createAscensionAnimation(playLayer, playerPos);
-    } else if (animationType == "slaughterhouse") {
-        createSlaughterhouseAnimation(playLayer, playerPos);
-    } else {
-        createExplosionAnimation(playLayer, playerPos);
+AnimationRunner* DeathAnimations::createAnimation(size_t animation, PlayLayer* playLayer, std::vector<CCPoint> const& origins, AnimationLayer* layer) {
+    auto prepared = prepareAnimation(animation, playLayer, layer);
+    if (!prepared) return nullptr;
+    return startAnimation(std::move(*prepared), playLayer, origins, layer);
+}
+
+AnimationRunner* DeathAnimations::createSelectedAnimation(PlayLayer* playLayer, std::vector<CCPoint> const& origins, AnimationLayer* layer, std::optional<Prepared> prepared) {
+    // A build from earlier in this attempt is only as good as the settings it was made with,
+    // and a dual portal since then changes how many players it is split between
+    auto const& config = Config::get();
+    size_t animation = config.animation;
+    if (prepared && prepared->attempt == playLayer->m_attempts && prepared->animation == animation && prepared->players == origins.size()
+        && prepared->duration == config.getDelay() && (prepared->flipbook || prepared->quality == config.getQuality())) {
+        Trace::instant(TraceEvent::Prebuilt);
+        return startAnimation(std::move(*prepared), playLayer, origins, layer);
     }
+    return createAnimation(animation, playLayer, origins, layer);
 }
@@ -1,12 +1,41 @@
 #pragma once
 #include <Geode/Geode.hpp>
+#include "AnimationLayer.hpp"
+#include "AnimationRunner.hpp"
+#include <optional>
 
 using namespace geode::prelude;
 
 class DeathAnimations {
 public:
-    static void createExplosionAnimation(PlayLayer* playLayer, CCPoint playerPos);
-    static void createAscensionAnimation(PlayLayer* playLayer, CCPoint playerPos);
-    static void createSlaughterhouseAnimation(PlayLayer* playLayer, CCPoint playerPos);
-    static void createSelectedAnimation(PlayLayer* playLayer, CCPoint playerPos);
+    // A timeline built before the death it is for, only valid for the attempt it was built in
+    struct Prepared {
+        size_t animation = 0;
+        int attempt = 0;
+        float duration = 0.0f;      // what it was scaled to
+        Quality quality = Quality::High;
+        bool adaptive = false;
+        bool flipbook = false;      // built to play next to the baked flipbook
+        uint8_t players = 1;
+        Timeline timeline;
+    };
+
+    static void loadDefinitions();
+    // Every loaded animation is registered under its index in file name order when the definitions
+    // load. For settings: unknown names are reported and fall back to explosion, or the first animation
+    static size_t resolveAnimation(std::string_view name);
+
+    static void runBenchmark(int iterations);
+    static void prewarm(AnimationLayer* layer);
+    // Uploads the flipbook once its bake is done; called every frame, so the upload lands during
+    // play rather than on the death that first wants it
+    static void updateFlipbook();
+    // Drops the flipbook texture while the GL context is still there; the next prewarm reads it back
+    static void releaseFlipbook();
+    static std::optional<Prepared> prepareAnimation(size_t animation, PlayLayer* playLayer, AnimationLayer* layer);
+    static std::optional<Prepared> prepareSelectedAnimation(PlayLayer* playLayer, AnimationLayer* layer);
+    // One death position per player, two in dual mode, which share one animation's fragments
+    static AnimationRunner* startAnimation(Prepared&& prepared, PlayLayer* playLayer, std::vector<CCPoint> const& origins, AnimationLayer* layer);
+    static AnimationRunner* createSelectedAnimation(PlayLayer* playLayer, std::vector<CCPoint> const& origins, AnimationLayer* layer, std::optional<Prepared> prepared = std::nullopt);
+    static AnimationRunner* createAnimation(size_t animation, PlayLayer* playLayer, std::vector<CCPoint> const& origins, AnimationLayer* layer);
 };
@@ -0,0 +1,69 @@
+#include "DeathHeatmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace {
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    bool byKey(DeathHeatmap::Cell const& a, DeathHeatmap::Cell const& b) {
+        return a.key < b.key;
+    }
+}
+
+uint32_t DeathHeatmap::keyFor(float x, float y) {
+    // Anything off either end of the level lands in the first or last cell
+    auto cell = [](float value, uint32_t max) {
+        return static_cast<uint32_t>(std::clamp(std::floor(value / kCellSize), 0.0f, static_cast<float>(max)));
+    };
+    return cell(y, kMaxCellY) << 16 | cell(x, 0xFFFF);
+}
+
+DeathHeatmap DeathHeatmap::load(std::filesystem::path const& path) {
+    DeathHeatmap heatmap;
+    std::ifstream file(path, std::ios::binary);
+    Header header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return heatmap;
+    if (header.magic != kMagic || header.version != kVersion) return heatmap;
+
+    heatmap.m_cells.resize(header.count);
+    file.read(reinterpret_cast<char*>(heatmap.m_cells.data()), header.count * sizeof(Cell));
+    heatmap.m_cells.resize(static_cast<size_t>(file.gcount()) / sizeof(Cell));
+
+    // Written sorted; a file edited by hand still loads, just slower
+    if (!std::is_sorted(heatmap.m_cells.begin(), heatmap.m_cells.end(), byKey)) {
+        std::sort(heatmap.m_cells.begin(), heatmap.m_cells.end(), byKey);
+    }
+    for (auto const& cell : heatmap.m_cells) {
+        heatmap.m_deaths += cell.count;
+    }
+    return heatmap;
+}
+
+bool DeathHeatmap::save(std::filesystem::path const& path) const {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    Header header = { kMagic, kVersion, static_cast<uint32_t>(m_cells.size()), 0 };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_cells.data()), m_cells.size() * sizeof(Cell));
+    return static_cast<bool>(file);
+}
+
+DeathHeatmap::Cell const& DeathHeatmap::add(float x, float y) {
+    Cell cell = { keyFor(x, y), 0 };
+    auto it = std::lower_bound(m_cells.begin(), m_cells.end(), cell, byKey);
+    if (it == m_cells.end() || it->key != cell.key) {
+        it = m_cells.insert(it, cell);
+    }
+    it->count++;
+    m_deaths++;
+    return *it;
+}
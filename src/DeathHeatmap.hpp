@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Death counts of one level, binned into block-sized cells over level space. Only cells with a
+// death are stored, sorted by key, both in memory and on disk, so loading is one read even for
+// a level with a hundred thousand deaths, and a new death touches a single cell.
+class DeathHeatmap {
+public:
+    static constexpr float kCellSize = 30.0f;           // one block
+    static constexpr uint32_t kMaxCellY = 0xFFFF;
+    static constexpr uint32_t kMagic = 0x50414D48;      // "HMAP"
+    static constexpr uint32_t kVersion = 1;
+
+    struct Cell {
+        uint32_t key;       // row << 16 | column
+        uint32_t count;
+    };
+    static_assert(sizeof(Cell) == 8);
+
+    static uint32_t keyFor(float x, float y);
+    static uint32_t columnOf(uint32_t key) { return key & 0xFFFF; }
+    static uint32_t rowOf(uint32_t key) { return key >> 16; }
+
+    static DeathHeatmap load(std::filesystem::path const& path);
+    bool save(std::filesystem::path const& path) const;
+
+    // Returns the cell the death landed in, with its new count
+    Cell const& add(float x, float y);
+
+    const std::vector<Cell>& getCells() const { return m_cells; }
+    uint64_t getDeathCount() const { return m_deaths; }
+
+private:
+    std::vector<Cell> m_cells;
+    uint64_t m_deaths = 0;
+};
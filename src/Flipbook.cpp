@@ -0,0 +1,362 @@
+#include "Flipbook.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <tuple>
+
+namespace {
+    constexpr float kDegreesToRadians = 3.14159265f / 180.0f;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t fingerprint;
+        uint32_t frameCount;
+        uint32_t frameWidth;
+        uint32_t frameHeight;
+        uint32_t columns;
+        float duration;
+        float pixelsPerUnit;
+        float originX;
+        float originY;
+        int32_t zOrder;
+        uint32_t encodedCount;  // uint16s after the header
+    };
+
+    // One fragment or particle on one frame, in the order cocos2d would draw it: by layer, a
+    // layer's batch before its bursts, then by Z-order within the batch
+    struct Item {
+        int layerZ;
+        int group;      // 0 for the batch, 1 + burst index for a burst
+        int zOrder;
+        uint32_t index;
+        float x;        // center, units from the origin
+        float y;
+        float scaleX;   // signed, a negative one mirrors
+        float scaleY;
+        float rotation; // degrees, clockwise
+        float r;        // tint and opacity, 0 to 1
+        float g;
+        float b;
+        float a;
+    };
+
+    bool drawsBefore(Item const& left, Item const& right) {
+        return std::tie(left.layerZ, left.group, left.zOrder, left.index) < std::tie(right.layerZ, right.group, right.zOrder, right.index);
+    }
+
+    void collect(Timeline const& timeline, std::vector<ParticleBurst>& bursts, Quality quality, float time,
+        std::vector<uint32_t>& cursors, std::vector<Item>& items) {
+        auto const& fragments = timeline.getFragments();
+        auto const& layers = timeline.getLayers();
+        for (size_t fragment = 0; fragment < fragments.size(); fragment++) {
+            auto const& desc = fragments[fragment];
+            if (!Flipbook::covers(desc) || desc.detail > quality) continue;
+            if (time < desc.start || time >= desc.end || time >= desc.hidden) continue;
+
+            uint32_t* cursor = &cursors[fragment * Timeline::ChannelCount];
+            auto value = [&](Timeline::Channel channel) {
+                return timeline.evaluate(fragment, channel, time, cursor[channel]);
+            };
+            float opacity = std::clamp(value(Timeline::Opacity), 0.0f, 255.0f) / 255.0f;
+            float scale = value(Timeline::Scale);
+            if (opacity <= 0.0f || scale == 0.0f) continue;
+
+            items.push_back({
+                layers[desc.layer], 0, desc.zOrder, static_cast<uint32_t>(fragment),
+                value(Timeline::X), value(Timeline::Y), scale * desc.scaleX, scale * desc.scaleY, value(Timeline::Rotation),
+                std::clamp(value(Timeline::Red), 0.0f, 255.0f) / 255.0f,
+                std::clamp(value(Timeline::Green), 0.0f, 255.0f) / 255.0f,
+                std::clamp(value(Timeline::Blue), 0.0f, 255.0f) / 255.0f,
+                opacity
+            });
+        }
+
+        for (size_t index = 0; index < bursts.size(); index++) {
+            auto& burst = bursts[index];
+            burst.stepScalar(time);
+            auto colors = burst.getColors();
+            for (size_t i = 0; i < burst.size(); i++) {
+                float scale = burst.getScale()[i];
+                float alpha = burst.getAlpha()[i];
+                // Same cut-off as BurstNode
+                if (scale <= 0.0f || alpha < 0.5f) continue;
+                items.push_back({
+                    layers[burst.getLayer()], static_cast<int>(index) + 1, 0, static_cast<uint32_t>(i),
+                    burst.getX()[i], burst.getY()[i], scale, scale, burst.getRotation()[i],
+                    colors[i].r / 255.0f, colors[i].g / 255.0f, colors[i].b / 255.0f,
+                    std::min(alpha, 255.0f) / 255.0f
+                });
+            }
+        }
+        std::sort(items.begin(), items.end(), drawsBefore);
+    }
+
+    // Premultiplied "over", the blending CCSprite and BurstNode draw with
+    void draw(Item const& item, Flipbook::Stamp const& stamp, float pixelsPerUnit, float left, float bottom,
+        uint32_t width, uint32_t height, std::vector<float>& frame) {
+        float halfX = stamp.unitWidth * 0.5f * item.scaleX * pixelsPerUnit;
+        float halfY = stamp.unitHeight * 0.5f * item.scaleY * pixelsPerUnit;
+        if (halfX == 0.0f || halfY == 0.0f) return;
+
+        float centerX = (item.x - left) * pixelsPerUnit;
+        float centerY = (item.y - bottom) * pixelsPerUnit;
+        float cos = std::cos(item.rotation * kDegreesToRadians);
+        float sin = std::sin(item.rotation * kDegreesToRadians);
+        float extentX = std::abs(halfX * cos) + std::abs(halfY * sin);
+        float extentY = std::abs(halfX * sin) + std::abs(halfY * cos);
+
+        int x0 = std::max(0, static_cast<int>(std::floor(centerX - extentX)));
+        int x1 = std::min(static_cast<int>(width) - 1, static_cast<int>(std::ceil(centerX + extentX)));
+        int y0 = std::max(0, static_cast<int>(std::floor(centerY - extentY)));
+        int y1 = std::min(static_cast<int>(height) - 1, static_cast<int>(std::ceil(centerY + extentY)));
+
+        float tintR = item.r * item.a;
+        float tintG = item.g * item.a;
+        float tintB = item.b * item.a;
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                // Back into the stamp: cocos2d rotations are clockwise, y points up
+                float dx = x + 0.5f - centerX;
+                float dy = y + 0.5f - centerY;
+                float u = (dx * cos - dy * sin) / halfX * 0.5f + 0.5f;
+                float v = 0.5f - (dx * sin + dy * cos) / halfY * 0.5f;
+                if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f) continue;
+
+                auto texel = &stamp.pixels[(static_cast<size_t>(v * stamp.height) * stamp.width + static_cast<size_t>(u * stamp.width)) * 4];
+                float alpha = texel[3] / 255.0f * item.a;
+                float* pixel = &frame[(static_cast<size_t>(y) * width + x) * 4];
+                float keep = 1.0f - alpha;
+                pixel[0] = texel[0] / 255.0f * tintR + pixel[0] * keep;
+                pixel[1] = texel[1] / 255.0f * tintG + pixel[1] * keep;
+                pixel[2] = texel[2] / 255.0f * tintB + pixel[2] * keep;
+                pixel[3] = alpha + pixel[3] * keep;
+            }
+        }
+    }
+
+    // Straight alpha, 4 bits a channel; anything close to transparent is exactly 0 for the encoder
+    uint16_t toRGBA4444(const float* pixel) {
+        float alpha = std::min(pixel[3], 1.0f);
+        auto nibble = [](float value) {
+            return static_cast<uint16_t>(std::clamp(value * 15.0f + 0.5f, 0.0f, 15.0f));
+        };
+        uint16_t a = nibble(alpha);
+        if (a == 0) return 0;
+        return static_cast<uint16_t>(nibble(pixel[0] / alpha) << 12 | nibble(pixel[1] / alpha) << 8 | nibble(pixel[2] / alpha) << 4 | a);
+    }
+}
+
+Flipbook::Stamp Flipbook::Stamp::square(uint32_t size, float units) {
+    Stamp stamp;
+    stamp.width = size;
+    stamp.height = size;
+    stamp.unitWidth = units;
+    stamp.unitHeight = units;
+    stamp.pixels.resize(static_cast<size_t>(size) * size * 4);
+
+    uint32_t rim = std::max(1u, size / 8);
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            bool edge = x < rim || y < rim || x >= size - rim || y >= size - rim;
+            uint8_t value = edge ? 140 : 255;
+            auto pixel = &stamp.pixels[(static_cast<size_t>(y) * size + x) * 4];
+            pixel[0] = value;
+            pixel[1] = value;
+            pixel[2] = value;
+            pixel[3] = 255;
+        }
+    }
+    return stamp;
+}
+
+bool Flipbook::covers(Timeline::Fragment const& fragment) {
+    return fragment.target == Timeline::Target::Fragment && !fragment.centered && fragment.origin == 0;
+}
+
+void Flipbook::removeCovered(Timeline& timeline) {
+    timeline.removeFragments(&Flipbook::covers);
+    timeline.getBursts().clear();
+}
+
+// ===============================================================================================
+// BAKING
+
+Flipbook Flipbook::bake(Timeline const& timeline, Quality quality, Stamp const& stamp, Settings const& settings) {
+    Flipbook flipbook;
+    float duration = timeline.getDuration();
+    if (duration <= 0.0f || stamp.pixels.empty()) return flipbook;
+
+    uint32_t frameCount = std::max(2u, static_cast<uint32_t>(std::ceil(duration * settings.fps)) + 1);
+    std::vector<ParticleBurst> bursts = timeline.getBursts();
+    for (auto& burst : bursts) {
+        burst.retireAbove(quality);
+    }
+
+    // Everything every frame draws, kept for the second pass once the frame size is known
+    std::vector<uint32_t> cursors(timeline.getFragments().size() * Timeline::ChannelCount, 0);
+    std::vector<Item> items;
+    std::vector<size_t> offsets = { 0 };
+    std::vector<Item> frameItems;
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        frameItems.clear();
+        collect(timeline, bursts, quality, duration * frame / (frameCount - 1), cursors, frameItems);
+        items.insert(items.end(), frameItems.begin(), frameItems.end());
+        offsets.push_back(items.size());
+    }
+    if (items.empty()) return flipbook;
+
+    float left = std::numeric_limits<float>::infinity();
+    float right = -left;
+    float bottom = left;
+    float top = -left;
+    int zOrder = std::numeric_limits<int>::max();
+    float radius = std::sqrt(stamp.unitWidth * stamp.unitWidth + stamp.unitHeight * stamp.unitHeight) * 0.5f;
+    for (auto const& item : items) {
+        float reach = radius * std::max(std::abs(item.scaleX), std::abs(item.scaleY));
+        left = std::min(left, item.x - reach);
+        right = std::max(right, item.x + reach);
+        bottom = std::min(bottom, item.y - reach);
+        top = std::max(top, item.y + reach);
+        zOrder = std::min(zOrder, item.layerZ);
+    }
+
+    // As sharp as the frame size allows, then smaller until every frame fits in one atlas
+    float extentX = std::max(right - left, 1.0f);
+    float extentY = std::max(top - bottom, 1.0f);
+    float pixelsPerUnit = settings.frameSize / std::max(extentX, extentY);
+    uint32_t width, height, columns;
+    while (true) {
+        width = std::max(1u, static_cast<uint32_t>(std::ceil(extentX * pixelsPerUnit)));
+        height = std::max(1u, static_cast<uint32_t>(std::ceil(extentY * pixelsPerUnit)));
+        columns = std::max(1u, kMaxAtlasSize / width);
+        uint32_t rows = (frameCount + columns - 1) / columns;
+        if ((rows * height <= kMaxAtlasSize && width <= kMaxAtlasSize) || width == 1) break;
+        pixelsPerUnit *= 0.9f;
+    }
+
+    flipbook.m_frameCount = frameCount;
+    flipbook.m_frameWidth = width;
+    flipbook.m_frameHeight = height;
+    flipbook.m_columns = columns;
+    flipbook.m_duration = duration;
+    flipbook.m_pixelsPerUnit = pixelsPerUnit;
+    flipbook.m_originX = -left * pixelsPerUnit;
+    flipbook.m_originY = -bottom * pixelsPerUnit;
+    flipbook.m_zOrder = zOrder;
+    flipbook.m_pixels.assign(static_cast<size_t>(flipbook.getAtlasWidth()) * flipbook.getAtlasHeight(), 0);
+
+    std::vector<float> pixels(static_cast<size_t>(width) * height * 4);
+    size_t stride = flipbook.getAtlasWidth();
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        std::fill(pixels.begin(), pixels.end(), 0.0f);
+        for (size_t item = offsets[frame]; item < offsets[frame + 1]; item++) {
+            draw(items[item], stamp, pixelsPerUnit, left, bottom, width, height, pixels);
+        }
+
+        // Frames are drawn y up and stored top down
+        size_t atlasX = (frame % columns) * width;
+        size_t atlasY = (frame / columns) * height;
+        for (uint32_t y = 0; y < height; y++) {
+            uint16_t* row = &flipbook.m_pixels[(atlasY + height - 1 - y) * stride + atlasX];
+            for (uint32_t x = 0; x < width; x++) {
+                row[x] = toRGBA4444(&pixels[(static_cast<size_t>(y) * width + x) * 4]);
+            }
+        }
+    }
+    return flipbook;
+}
+
+uint32_t Flipbook::frameAt(float progress) const {
+    if (m_frameCount == 0) return 0;
+    float frame = std::clamp(progress, 0.0f, 1.0f) * (m_frameCount - 1) + 0.5f;
+    return std::min(static_cast<uint32_t>(frame), m_frameCount - 1);
+}
+
+void Flipbook::releasePixels() {
+    m_pixels.clear();
+    m_pixels.shrink_to_fit();
+}
+
+// ===============================================================================================
+// CACHE - Runs of transparent pixels, then runs of anything else, as uint16 counts
+
+std::vector<uint16_t> Flipbook::encode() const {
+    std::vector<uint16_t> encoded;
+    size_t i = 0;
+    while (i < m_pixels.size()) {
+        size_t zeros = 0;
+        while (i + zeros < m_pixels.size() && m_pixels[i + zeros] == 0 && zeros < 0xFFFF) {
+            zeros++;
+        }
+        i += zeros;
+        size_t literals = 0;
+        while (i + literals < m_pixels.size() && m_pixels[i + literals] != 0 && literals < 0xFFFF) {
+            literals++;
+        }
+        encoded.push_back(static_cast<uint16_t>(zeros));
+        encoded.push_back(static_cast<uint16_t>(literals));
+        encoded.insert(encoded.end(), m_pixels.begin() + i, m_pixels.begin() + i + literals);
+        i += literals;
+    }
+    return encoded;
+}
+
+size_t Flipbook::getEncodedSize() const {
+    return sizeof(Header) + encode().size() * sizeof(uint16_t);
+}
+
+bool Flipbook::save(std::filesystem::path const& path, uint64_t fingerprint) const {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    auto encoded = encode();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    Header header = {
+        kMagic, kVersion, fingerprint, m_frameCount, m_frameWidth, m_frameHeight, m_columns,
+        m_duration, m_pixelsPerUnit, m_originX, m_originY, m_zOrder, static_cast<uint32_t>(encoded.size())
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size() * sizeof(uint16_t));
+    return static_cast<bool>(file);
+}
+
+Flipbook Flipbook::load(std::filesystem::path const& path, uint64_t fingerprint) {
+    Flipbook flipbook;
+    std::ifstream file(path, std::ios::binary);
+    Header header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return flipbook;
+    if (header.magic != kMagic || header.version != kVersion || header.fingerprint != fingerprint) return flipbook;
+    if (header.frameCount == 0 || header.columns == 0 || header.frameWidth * header.columns > kMaxAtlasSize) return flipbook;
+
+    std::vector<uint16_t> encoded(header.encodedCount);
+    if (!file.read(reinterpret_cast<char*>(encoded.data()), encoded.size() * sizeof(uint16_t))) return flipbook;
+
+    Flipbook result;
+    result.m_frameCount = header.frameCount;
+    result.m_frameWidth = header.frameWidth;
+    result.m_frameHeight = header.frameHeight;
+    result.m_columns = header.columns;
+    result.m_duration = header.duration;
+    result.m_pixelsPerUnit = header.pixelsPerUnit;
+    result.m_originX = header.originX;
+    result.m_originY = header.originY;
+    result.m_zOrder = header.zOrder;
+    if (result.getAtlasHeight() > kMaxAtlasSize) return flipbook;
+
+    size_t size = static_cast<size_t>(result.getAtlasWidth()) * result.getAtlasHeight();
+    result.m_pixels.reserve(size);
+    size_t i = 0;
+    while (i + 1 < encoded.size()) {
+        size_t zeros = encoded[i];
+        size_t literals = encoded[i + 1];
+        i += 2;
+        if (result.m_pixels.size() + zeros + literals > size || i + literals > encoded.size()) return flipbook;
+        result.m_pixels.insert(result.m_pixels.end(), zeros, 0);
+        result.m_pixels.insert(result.m_pixels.end(), encoded.begin() + i, encoded.begin() + i + literals);
+        i += literals;
+    }
+    if (result.m_pixels.size() != size) return flipbook;
+    return result;
+}
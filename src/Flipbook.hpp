@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "Timeline.hpp"
+
+// An animation's fragments and particles rendered ahead of time, one frame per step at a fixed
+// frame rate, packed into a single atlas that plays back as one textured quad at the death
+// position. Only what is drawn relative to the death is baked: the player, overlays, screen
+// effects and fragments placed from the middle of the screen keep playing live.
+// Baking is a software rasterizer over a Timeline, with no cocos2d or GL, so it runs on a worker
+// thread in game and headlessly anywhere else. Pixels are RGBA4444 with straight alpha, half the
+// size of RGBA8888 on the GPU, and the transparent runs that make up most of a frame are
+// run-length encoded on disk.
+class Flipbook {
+public:
+    static constexpr uint32_t kMagic = 0x50494C46;      // "FLIP"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMaxAtlasSize = 4096;     // the smallest texture size limit GD runs on
+
+    // What every fragment and particle is drawn with, premultiplied RGBA with row 0 at the top
+    struct Stamp {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        float unitWidth = 0.0f;     // its size in the scene at scale 1
+        float unitHeight = 0.0f;
+        std::vector<uint8_t> pixels;
+
+        // Where the game texture can't be read: a white square with a darker rim, like GJ_square01
+        static Stamp square(uint32_t size, float units);
+    };
+
+    struct Settings {
+        uint32_t frameSize = 256;   // longest side of a frame in pixels
+        float fps = 30.0f;
+    };
+
+    static bool covers(Timeline::Fragment const& fragment);
+    // Leaves only what the flipbook doesn't draw, bursts included, for the runner to play alongside it
+    static void removeCovered(Timeline& timeline);
+
+    // Renders `timeline` at its own pace on the given tier, single player only
+    static Flipbook bake(Timeline const& timeline, Quality quality, Stamp const& stamp, Settings const& settings);
+    // Empty when missing, unreadable or baked from something else than `fingerprint`
+    static Flipbook load(std::filesystem::path const& path, uint64_t fingerprint);
+    bool save(std::filesystem::path const& path, uint64_t fingerprint) const;
+
+    // Frame shown `progress` of the way through, 0 to 1
+    uint32_t frameAt(float progress) const;
+
+    bool empty() const { return m_frameCount == 0; }
+    uint32_t getFrameCount() const { return m_frameCount; }
+    uint32_t getFrameWidth() const { return m_frameWidth; }
+    uint32_t getFrameHeight() const { return m_frameHeight; }
+    uint32_t getColumns() const { return m_columns; }
+    uint32_t getAtlasWidth() const { return m_columns * m_frameWidth; }
+    uint32_t getAtlasHeight() const { return (m_frameCount + m_columns - 1) / m_columns * m_frameHeight; }
+    float getDuration() const { return m_duration; }
+    float getPixelsPerUnit() const { return m_pixelsPerUnit; }
+    float getOriginX() const { return m_originX; }     // the death position in a frame, pixels from its bottom left
+    float getOriginY() const { return m_originY; }
+    int getZOrder() const { return m_zOrder; }          // of the lowest layer it draws
+
+    const uint16_t* getPixels() const { return m_pixels.data(); }
+    // Once the pixels are on the GPU only the layout is needed
+    void releasePixels();
+    size_t getMemoryUsage() const { return static_cast<size_t>(getAtlasWidth()) * getAtlasHeight() * sizeof(uint16_t); }
+    size_t getEncodedSize() const;
+
+private:
+    std::vector<uint16_t> encode() const;
+
+    uint32_t m_frameCount = 0;
+    uint32_t m_frameWidth = 0;
+    uint32_t m_frameHeight = 0;
+    uint32_t m_columns = 0;
+    float m_duration = 0.0f;
+    float m_pixelsPerUnit = 1.0f;
+    float m_originX = 0.0f;
+    float m_originY = 0.0f;
+    int m_zOrder = 0;
+    std::vector<uint16_t> m_pixels;     // the whole atlas, rows top down
+};
@@ -0,0 +1,60 @@
+#include <Geode/Geode.hpp>
+#include "FlipbookNode.hpp"
+
+using namespace geode::prelude;
+
+FlipbookNode* FlipbookNode::create(PlayLayer* playLayer, CCTexture2D* texture, Flipbook const& flipbook, CCPoint origin, float duration) {
+    auto ret = new FlipbookNode();
+    if (ret->init(playLayer, texture, flipbook, origin, duration)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool FlipbookNode::init(PlayLayer* playLayer, CCTexture2D* texture, Flipbook const& flipbook, CCPoint origin, float duration) {
+    if (flipbook.empty() || duration <= 0.0f) return false;
+
+    // Only the layout is kept, the flipbook itself may be replaced while this still plays
+    float scale = CC_CONTENT_SCALE_FACTOR();
+    m_frameSize = CCSize(flipbook.getFrameWidth() / scale, flipbook.getFrameHeight() / scale);
+    if (!CCSprite::initWithTexture(texture, CCRect(0.0f, 0.0f, m_frameSize.width, m_frameSize.height))) return false;
+
+    m_playLayer = playLayer;
+    m_duration = duration;
+    m_frameCount = flipbook.getFrameCount();
+    m_columns = flipbook.getColumns();
+
+    // The death position sits where it was in the bake, and a frame pixel covers what it did there
+    this->setAnchorPoint(ccp(flipbook.getOriginX() / flipbook.getFrameWidth(), flipbook.getOriginY() / flipbook.getFrameHeight()));
+    this->setPosition(origin);
+    this->setScale(scale / flipbook.getPixelsPerUnit());
+
+    this->setID("flipbook"_spr);
+    this->scheduleUpdate();
+    return true;
+}
+
+void FlipbookNode::showFrame(uint32_t frame) {
+    m_frame = frame;
+    this->setTextureRect(CCRect(
+        (frame % m_columns) * m_frameSize.width, (frame / m_columns) * m_frameSize.height,
+        m_frameSize.width, m_frameSize.height
+    ));
+}
+
+void FlipbookNode::update(float dt) {
+    if (m_playLayer->m_isPaused) return;
+    m_time += dt;
+    if (m_time >= m_duration) {
+        this->removeFromParentAndCleanup(true);
+        return;
+    }
+
+    float progress = m_time / m_duration;
+    uint32_t frame = std::min(static_cast<uint32_t>(progress * (m_frameCount - 1) + 0.5f), m_frameCount - 1);
+    if (frame != m_frame) {
+        showFrame(frame);
+    }
+}
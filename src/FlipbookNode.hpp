@@ -0,0 +1,27 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "Flipbook.hpp"
+
+using namespace geode::prelude;
+
+// Plays a baked Flipbook as one quad at the death position: each frame only moves the texture
+// rect. Stretched to the animation's duration like the runner playing alongside it, held behind
+// the pause menu, and gone once it ends. Lives in the AnimationLayer, so resets clear it too.
+class FlipbookNode : public CCSprite {
+public:
+    static FlipbookNode* create(PlayLayer* playLayer, CCTexture2D* texture, Flipbook const& flipbook, CCPoint origin, float duration);
+
+    void update(float dt) override;
+
+private:
+    bool init(PlayLayer* playLayer, CCTexture2D* texture, Flipbook const& flipbook, CCPoint origin, float duration);
+    void showFrame(uint32_t frame);
+
+    PlayLayer* m_playLayer = nullptr;
+    float m_time = 0.0f;
+    float m_duration = 0.0f;
+    uint32_t m_frameCount = 0;
+    uint32_t m_columns = 1;
+    uint32_t m_frame = 0;
+    CCSize m_frameSize;     // in points
+};
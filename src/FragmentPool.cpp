@@ -0,0 +1,145 @@
+#include <Geode/Geode.hpp>
+#include "FragmentPool.hpp"
+
+using namespace geode::prelude;
+
+void FragmentPool::warm(size_t fragments, size_t batches, size_t overlays) {
+    while (m_fragments.size() < fragments) {
+        m_freeFragments.push_back(allocateFragment());
+    }
+    while (m_batches.size() < batches) {
+        m_freeBatches.push_back(allocateBatch());
+    }
+    while (m_overlays.size() < overlays) {
+        m_freeOverlays.push_back(allocateOverlay());
+    }
+}
+
+void FragmentPool::warmAtlases(std::vector<size_t> capacities) {
+    // Largest first against the largest free atlases, anything left over gets a new one
+    std::vector<size_t> free;
+    for (auto atlas : m_freeAtlases) {
+        free.push_back(atlas->getCapacity());
+    }
+    std::sort(capacities.begin(), capacities.end(), std::greater<>());
+    std::sort(free.begin(), free.end(), std::greater<>());
+
+    size_t next = 0;
+    for (size_t capacity : capacities) {
+        if (next < free.size() && free[next] >= capacity) {
+            next++;
+        } else {
+            m_freeAtlases.push_back(allocateAtlas(capacity));
+        }
+    }
+}
+
+CCSprite* FragmentPool::checkout() {
+    CCSprite* fragment;
+    if (m_freeFragments.empty()) {
+        fragment = allocateFragment();
+    } else {
+        fragment = m_freeFragments.back();
+        m_freeFragments.pop_back();
+    }
+
+    // Pooled fragments come back in whatever state their last animation left them
+    fragment->setScale(1.0f);
+    fragment->setRotation(0.0f);
+    fragment->setColor(ccc3(255, 255, 255));
+    fragment->setOpacity(255);
+    fragment->setVisible(true);
+    return fragment;
+}
+
+void FragmentPool::release(CCSprite* fragment) {
+    fragment->removeFromParentAndCleanup(true);
+    m_freeFragments.push_back(fragment);
+}
+
+CCSpriteBatchNode* FragmentPool::checkoutBatch() {
+    if (m_freeBatches.empty()) {
+        return allocateBatch();
+    }
+    auto batch = m_freeBatches.back();
+    m_freeBatches.pop_back();
+    return batch;
+}
+
+void FragmentPool::releaseBatch(CCSpriteBatchNode* batch) {
+    // Fragments still running when the batch expires go back to the pool too
+    auto children = batch->getChildren();
+    while (children && children->count() > 0) {
+        this->release(static_cast<CCSprite*>(children->lastObject()));
+    }
+    batch->removeFromParentAndCleanup(true);
+    m_freeBatches.push_back(batch);
+}
+
+CCLayerColor* FragmentPool::checkoutOverlay() {
+    if (m_freeOverlays.empty()) {
+        return allocateOverlay();
+    }
+    auto overlay = m_freeOverlays.back();
+    m_freeOverlays.pop_back();
+    return overlay;
+}
+
+void FragmentPool::releaseOverlay(CCLayerColor* overlay) {
+    overlay->removeFromParentAndCleanup(true);
+    m_freeOverlays.push_back(overlay);
+}
+
+CCTextureAtlas* FragmentPool::checkoutAtlas(size_t capacity) {
+    auto best = m_freeAtlases.end();
+    for (auto it = m_freeAtlases.begin(); it != m_freeAtlases.end(); ++it) {
+        if ((*it)->getCapacity() >= capacity && (best == m_freeAtlases.end() || (*it)->getCapacity() < (*best)->getCapacity())) {
+            best = it;
+        }
+    }
+    if (best == m_freeAtlases.end()) {
+        return allocateAtlas(capacity);
+    }
+    auto atlas = *best;
+    m_freeAtlases.erase(best);
+    return atlas;
+}
+
+void FragmentPool::releaseAtlas(CCTextureAtlas* atlas) {
+    m_freeAtlases.push_back(atlas);
+}
+
+CCTexture2D* FragmentPool::getTexture() {
+    if (!m_texture) {
+        m_texture = CCTextureCache::sharedTextureCache()->addImage("GJ_square01.png", false);
+    }
+    return m_texture;
+}
+
+CCSprite* FragmentPool::allocateFragment() {
+    auto fragment = CCSprite::createWithTexture(getTexture());
+    m_fragments.push_back(fragment);
+    m_allocations++;
+    return fragment;
+}
+
+CCSpriteBatchNode* FragmentPool::allocateBatch() {
+    auto batch = CCSpriteBatchNode::createWithTexture(getTexture(), 64);
+    m_batches.push_back(batch);
+    m_allocations++;
+    return batch;
+}
+
+CCLayerColor* FragmentPool::allocateOverlay() {
+    auto overlay = CCLayerColor::create(ccc4(0, 0, 0, 0));
+    m_overlays.push_back(overlay);
+    m_allocations++;
+    return overlay;
+}
+
+CCTextureAtlas* FragmentPool::allocateAtlas(size_t capacity) {
+    auto atlas = CCTextureAtlas::createWithTexture(getTexture(), static_cast<unsigned>(std::max<size_t>(capacity, 1)));
+    m_atlases.push_back(atlas);
+    m_allocations++;
+    return atlas;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <Geode/Geode.hpp>
+
+using namespace geode::prelude;
+
+// Reusable fragment sprites, batch nodes, overlays and particle atlases for the death animations.
+// Owned by the PlayLayer and warmed when the level loads, so a new best only
+// checks out existing nodes instead of allocating (and later freeing) hundreds.
+class FragmentPool {
+public:
+    void warm(size_t fragments, size_t batches, size_t overlays = 0);
+    void warmAtlases(std::vector<size_t> capacities);   // enough free atlases to hold all of these at once
+
+    CCSprite* checkout();
+    void release(CCSprite* fragment);
+
+    CCSpriteBatchNode* checkoutBatch();
+    void releaseBatch(CCSpriteBatchNode* batch);
+
+    CCLayerColor* checkoutOverlay();
+    void releaseOverlay(CCLayerColor* overlay);
+
+    // Vertex buffers for particle bursts, the smallest free one that holds `capacity` quads
+    CCTextureAtlas* checkoutAtlas(size_t capacity);
+    void releaseAtlas(CCTextureAtlas* atlas);
+
+    CCTexture2D* getTexture();
+    CCSize getFragmentSize() { return getTexture()->getContentSize(); }
+    size_t getAllocationCount() const { return m_allocations; }
+
+private:
+    CCSprite* allocateFragment();
+    CCSpriteBatchNode* allocateBatch();
+    CCLayerColor* allocateOverlay();
+    CCTextureAtlas* allocateAtlas(size_t capacity);
+
+    Ref<CCTexture2D> m_texture;
+    std::vector<Ref<CCSprite>> m_fragments;
+    std::vector<CCSprite*> m_freeFragments;
+    std::vector<Ref<CCSpriteBatchNode>> m_batches;
+    std::vector<CCSpriteBatchNode*> m_freeBatches;
+    std::vector<Ref<CCLayerColor>> m_overlays;
+    std::vector<CCLayerColor*> m_freeOverlays;
+    std::vector<Ref<CCTextureAtlas>> m_atlases;
+    std::vector<CCTextureAtlas*> m_freeAtlases;
+    size_t m_allocations = 0;
+};
@@ -0,0 +1,104 @@
+#include <Geode/Geode.hpp>
+#include "GhostNode.hpp"
+
+using namespace geode::prelude;
+
+namespace {
+    constexpr float kFadeTime = 0.25f;
+
+    IconType iconTypeFor(GhostMode mode) {
+        switch (mode) {
+            case GhostMode::Ship: return IconType::Ship;
+            case GhostMode::Ball: return IconType::Ball;
+            case GhostMode::Ufo: return IconType::Ufo;
+            case GhostMode::Wave: return IconType::Wave;
+            case GhostMode::Robot: return IconType::Robot;
+            case GhostMode::Spider: return IconType::Spider;
+            case GhostMode::Swing: return IconType::Swing;
+            default: return IconType::Cube;
+        }
+    }
+}
+
+GhostNode* GhostNode::create(PlayLayer* playLayer, GhostTrack&& track, float duration) {
+    auto ret = new GhostNode();
+    if (ret->init(playLayer, std::move(track), duration)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+GhostMode GhostNode::modeOf(PlayerObject* player) {
+    if (player->m_isShip) return GhostMode::Ship;
+    if (player->m_isBall) return GhostMode::Ball;
+    if (player->m_isBird) return GhostMode::Ufo;
+    if (player->m_isDart) return GhostMode::Wave;
+    if (player->m_isRobot) return GhostMode::Robot;
+    if (player->m_isSpider) return GhostMode::Spider;
+    if (player->m_isSwing) return GhostMode::Swing;
+    return GhostMode::Cube;
+}
+
+bool GhostNode::init(PlayLayer* playLayer, GhostTrack&& track, float duration) {
+    if (!CCNode::init() || track.empty()) return false;
+
+    m_playLayer = playLayer;
+    m_track = std::move(track);
+    m_begin = std::max(m_track.getStart(), m_track.getEnd() - duration);
+    m_time = m_begin;
+
+    auto gm = GameManager::get();
+    m_icon = SimplePlayer::create(gm->activeIconForType(IconType::Cube));
+    m_icon->setColor(gm->colorForIdx(gm->getPlayerColor()));
+    m_icon->setSecondColor(gm->colorForIdx(gm->getPlayerColor2()));
+    m_icon->setOpacity(0);
+    this->addChild(m_icon);
+    setMode(m_track.sample(m_time).mode);
+
+    this->setID("ghost"_spr);
+    this->scheduleUpdate();
+    return true;
+}
+
+// The first frame is placed once there is a parent to map it into, before the first draw
+void GhostNode::onEnter() {
+    CCNode::onEnter();
+    update(0.0f);
+}
+
+void GhostNode::setMode(GhostMode mode) {
+    m_mode = mode;
+    auto type = iconTypeFor(mode);
+    m_icon->updatePlayerFrame(GameManager::get()->activeIconForType(type), type);
+}
+
+void GhostNode::update(float dt) {
+    auto parent = this->getParent();
+    if (!parent || m_playLayer->m_isPaused) return;
+    m_time += dt;
+    if (m_time > m_track.getEnd()) {
+        this->removeFromParentAndCleanup(true);
+        return;
+    }
+
+    auto sample = m_track.sample(m_time);
+    if (sample.mode != m_mode) {
+        setMode(sample.mode);
+    }
+
+    // Recorded in the object layer; mapped through it every frame, so camera moves carry over
+    auto objectLayer = m_playLayer->m_objectLayer;
+    auto position = parent->convertToNodeSpace(objectLayer->convertToWorldSpace(ccp(sample.x, sample.y)));
+    auto unit = parent->convertToNodeSpace(objectLayer->convertToWorldSpace(ccp(sample.x + 1.0f, sample.y))) - position;
+    float scale = std::sqrt(unit.x * unit.x + unit.y * unit.y);
+
+    m_icon->setPosition(position);
+    m_icon->setRotation(sample.rotation - CC_RADIANS_TO_DEGREES(std::atan2(unit.y, unit.x)));
+    m_icon->setScaleX(scale);
+    m_icon->setScaleY(sample.upsideDown ? -scale : scale);
+
+    float fade = std::min({ 1.0f, (m_time - m_begin) / kFadeTime, (m_track.getEnd() - m_time) / kFadeTime });
+    m_icon->setOpacity(static_cast<GLubyte>(kOpacity * std::max(fade, 0.0f)));
+}
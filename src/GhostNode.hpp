@@ -0,0 +1,31 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "GhostRecorder.hpp"
+
+using namespace geode::prelude;
+
+// A translucent copy of the player's icon replaying the end of the run under the death
+// animation, so it reaches the death position as the animation ends. Frames are interpolated from
+// the recording at whatever rate the game draws, and the icon switches with the recorded mode.
+// Lives in the AnimationLayer, so resets clear it with everything else.
+class GhostNode : public CCNode {
+public:
+    static constexpr GLubyte kOpacity = 110;
+
+    static GhostNode* create(PlayLayer* playLayer, GhostTrack&& track, float duration);
+    static GhostMode modeOf(PlayerObject* player);
+
+    void onEnter() override;
+    void update(float dt) override;
+
+private:
+    bool init(PlayLayer* playLayer, GhostTrack&& track, float duration);
+    void setMode(GhostMode mode);
+
+    PlayLayer* m_playLayer = nullptr;
+    GhostTrack m_track;
+    float m_time = 0.0f;        // on the recording's clock
+    float m_begin = 0.0f;
+    SimplePlayer* m_icon = nullptr;
+    GhostMode m_mode = GhostMode::Cube;
+};
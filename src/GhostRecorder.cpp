@@ -0,0 +1,120 @@
+#include "GhostRecorder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr uint8_t kUpsideDownBit = 0x80;
+
+    // A delta too big for its field is clamped; the next frames catch up, as they are taken
+    // against the decoded sample rather than the real one
+    template <class T>
+    T quantize(float delta, float step) {
+        return static_cast<T>(std::clamp(
+            std::round(delta / step),
+            static_cast<float>(std::numeric_limits<T>::min()),
+            static_cast<float>(std::numeric_limits<T>::max())
+        ));
+    }
+
+    float lerpAngle(float from, float to, float t) {
+        float delta = std::fmod(to - from + 540.0f, 360.0f) - 180.0f;
+        return from + delta * t;
+    }
+}
+
+GhostRecorder::GhostRecorder() {
+    m_deltas.resize(kCapacity);
+    m_keys.resize(kCapacity / kBlockSize);
+}
+
+void GhostRecorder::clear() {
+    m_count = 0;
+    m_time = 0.0f;
+}
+
+size_t GhostRecorder::size() const {
+    return static_cast<size_t>(std::min<uint64_t>(m_count, kCapacity));
+}
+
+void GhostRecorder::apply(GhostSample& sample, Delta const& delta) {
+    sample.time += delta.time * kTimeStep;
+    sample.x += delta.x * kPositionStep;
+    sample.y += delta.y * kPositionStep;
+    sample.rotation += delta.rotation * kRotationStep;
+    sample.mode = static_cast<GhostMode>(delta.state & ~kUpsideDownBit);
+    sample.upsideDown = delta.state & kUpsideDownBit;
+}
+
+void GhostRecorder::record(float dt, float x, float y, float rotation, GhostMode mode, bool upsideDown) {
+    m_time += dt;
+    size_t slot = m_count % kCapacity;
+    m_count++;
+
+    if (slot % kBlockSize == 0) {
+        m_last = { m_time, x, y, rotation, mode, upsideDown };
+        m_keys[slot / kBlockSize] = m_last;
+        return;
+    }
+
+    Delta delta = {
+        quantize<int16_t>(x - m_last.x, kPositionStep),
+        quantize<int16_t>(y - m_last.y, kPositionStep),
+        quantize<int16_t>(rotation - m_last.rotation, kRotationStep),
+        quantize<uint8_t>(m_time - m_last.time, kTimeStep),
+        static_cast<uint8_t>(static_cast<uint8_t>(mode) | (upsideDown ? kUpsideDownBit : 0))
+    };
+    m_deltas[slot] = delta;
+    apply(m_last, delta);
+}
+
+std::vector<GhostSample> GhostRecorder::extract(float seconds) const {
+    std::vector<GhostSample> samples;
+    if (m_count == 0) return samples;
+
+    // The block being written shares its key with the oldest one, which is lost from its start
+    uint64_t blocks = (m_count + kBlockSize - 1) / kBlockSize;
+    uint64_t oldest = blocks > kCapacity / kBlockSize ? blocks - kCapacity / kBlockSize + 1 : 0;
+
+    // Keys hold the absolute time, so the first block needed is found without decoding any
+    uint64_t first = blocks - 1;
+    while (first > oldest && m_keys[first % m_keys.size()].time > m_last.time - seconds) {
+        first--;
+    }
+
+    samples.reserve(static_cast<size_t>(m_count - first * kBlockSize));
+    for (uint64_t block = first; block < blocks; block++) {
+        GhostSample sample = m_keys[block % m_keys.size()];
+        samples.push_back(sample);
+        uint64_t end = std::min(m_count, (block + 1) * kBlockSize);
+        for (uint64_t index = block * kBlockSize + 1; index < end; index++) {
+            apply(sample, m_deltas[index % kCapacity]);
+            samples.push_back(sample);
+        }
+    }
+    return samples;
+}
+
+GhostSample GhostTrack::sample(float time) {
+    if (time <= m_samples.front().time) return m_samples.front();
+    if (time >= m_samples.back().time) return m_samples.back();
+
+    if (m_cursor >= m_samples.size() || m_samples[m_cursor].time > time) {
+        m_cursor = 0;
+    }
+    while (m_samples[m_cursor + 1].time <= time) {
+        m_cursor++;
+    }
+
+    auto const& from = m_samples[m_cursor];
+    auto const& to = m_samples[m_cursor + 1];
+    float span = to.time - from.time;
+    float t = span > 0.0f ? (time - from.time) / span : 1.0f;
+
+    GhostSample sample = from;
+    sample.time = time;
+    sample.x = from.x + (to.x - from.x) * t;
+    sample.y = from.y + (to.y - from.y) * t;
+    sample.rotation = lerpAngle(from.rotation, to.rotation, t);
+    return sample;
+}
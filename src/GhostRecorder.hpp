@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class GhostMode : uint8_t { Cube, Ship, Ball, Ufo, Wave, Robot, Spider, Swing };
+
+struct GhostSample {
+    float time;
+    float x, y;
+    float rotation;
+    GhostMode mode;
+    bool upsideDown;
+};
+
+// The player's position, rotation and mode on every frame of the attempt, kept in a fixed ring of
+// 8-byte deltas with a full sample at the start of every block. Recording is a few subtractions and
+// one store, nothing is allocated after construction, and the oldest blocks are overwritten once
+// the ring is full. Deltas are taken against the decoded previous sample, so rounding never adds up.
+class GhostRecorder {
+public:
+    static constexpr size_t kCapacity = 1 << 14;        // samples, over a minute at 240 Hz
+    static constexpr size_t kBlockSize = 256;           // samples per full sample
+    static constexpr float kPositionStep = 1.0f / 16;   // units
+    static constexpr float kRotationStep = 1.0f / 8;    // degrees
+    static constexpr float kTimeStep = 1.0f / 2000;     // seconds
+
+    GhostRecorder();
+
+    void clear();
+    void record(float dt, float x, float y, float rotation, GhostMode mode, bool upsideDown);
+
+    // Decodes at least the last few seconds still in the ring, oldest first
+    std::vector<GhostSample> extract(float seconds) const;
+
+    size_t size() const;
+    static constexpr size_t getMemoryUsage() {
+        return kCapacity * sizeof(Delta) + kCapacity / kBlockSize * sizeof(GhostSample);
+    }
+
+private:
+    struct Delta {
+        int16_t x, y;
+        int16_t rotation;
+        uint8_t time;
+        uint8_t state;      // mode in the low bits, upside down in the top bit
+    };
+    static_assert(sizeof(Delta) == 8);
+
+    static void apply(GhostSample& sample, Delta const& delta);
+
+    std::vector<Delta> m_deltas;
+    std::vector<GhostSample> m_keys;    // the first sample of each block
+    uint64_t m_count = 0;
+    float m_time = 0.0f;
+    GhostSample m_last = {};            // the last sample as it decodes
+};
+
+// A decoded stretch of a recording, sampled at any time in between its frames
+class GhostTrack {
+public:
+    GhostTrack() = default;
+    explicit GhostTrack(std::vector<GhostSample> samples) : m_samples(std::move(samples)) {}
+
+    bool empty() const { return m_samples.empty(); }
+    float getStart() const { return m_samples.front().time; }
+    float getEnd() const { return m_samples.back().time; }
+
+    // Position and rotation are interpolated, the mode is the one of the frame before. The cursor
+    // makes steadily increasing times cheap, going back searches again
+    GhostSample sample(float time);
+
+private:
+    std::vector<GhostSample> m_samples;
+    size_t m_cursor = 0;
+};
@@ -0,0 +1,123 @@
+#include <Geode/Geode.hpp>
+#include "HeatmapLayer.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace geode::prelude;
+
+namespace {
+    // A screen past the end, where the player can still die on the last jump
+    constexpr float kLevelMargin = 600.0f;
+    constexpr GLubyte kOpacity = 170;
+}
+
+HeatmapLayer* HeatmapLayer::create(PlayLayer* playLayer, bool onlyWhilePaused) {
+    auto ret = new HeatmapLayer();
+    if (ret->init(playLayer, onlyWhilePaused)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool HeatmapLayer::init(PlayLayer* playLayer, bool onlyWhilePaused) {
+    if (!CCNode::init()) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    m_playLayer = playLayer;
+    m_onlyWhilePaused = onlyWhilePaused;
+    m_path = Mod::get()->getSaveDir() / "heatmaps" / fmt::format("{}.bin", playLayer->m_level->m_levelID.value());
+    m_heatmap = DeathHeatmap::load(m_path);
+
+    // Long levels get wider texels rather than a texture the GPU might not take
+    auto cellColumns = static_cast<uint32_t>(std::ceil((playLayer->m_levelLength + kLevelMargin) / DeathHeatmap::kCellSize));
+    m_cellsPerTexel = std::max<uint32_t>(1, (cellColumns + kMaxColumns - 1) / kMaxColumns);
+    m_columns = std::max<uint32_t>(1, (cellColumns + m_cellsPerTexel - 1) / m_cellsPerTexel);
+
+    m_counts.assign(m_columns * kRows, 0);
+    for (auto const& cell : m_heatmap.getCells()) {
+        m_counts[texelOf(cell.key)] += cell.count;
+    }
+    m_pixels.resize(m_counts.size());
+    for (size_t texel = 0; texel < m_counts.size(); texel++) {
+        m_pixels[texel] = colorFor(m_counts[texel]);
+    }
+
+    m_texture = new CCTexture2D();
+    m_texture->initWithData(m_pixels.data(), kCCTexture2DPixelFormat_RGBA8888, m_columns, kRows, CCSize(m_columns, kRows));
+    m_texture->autorelease();
+
+    // One texel per cell block, row 0 at the bottom like level space. The texture measures itself
+    // in points, a texel being 1 / CSF of one, so the scale makes up for it
+    float scale = CC_CONTENT_SCALE_FACTOR();
+    m_sprite = CCSprite::createWithTexture(m_texture);
+    m_sprite->setFlipY(true);
+    m_sprite->setAnchorPoint(ccp(0.0f, 0.0f));
+    m_sprite->setScaleX(scale * m_cellsPerTexel * DeathHeatmap::kCellSize);
+    m_sprite->setScaleY(scale * DeathHeatmap::kCellSize);
+    m_sprite->setOpacity(kOpacity);
+    this->addChild(m_sprite);
+
+    this->setID("heatmap"_spr);
+    this->setVisible(!m_onlyWhilePaused);
+    playLayer->m_objectLayer->addChild(this);
+    this->scheduleUpdate();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    log::info("Loaded heatmap of {} deaths in {} cells ({}x{} texels) in {}us",
+        m_heatmap.getDeathCount(), m_heatmap.getCells().size(), m_columns, kRows, elapsed.count()
+    );
+    return true;
+}
+
+uint32_t HeatmapLayer::texelOf(uint32_t key) const {
+    uint32_t column = std::min(DeathHeatmap::columnOf(key) / m_cellsPerTexel, m_columns - 1);
+    uint32_t row = std::min(DeathHeatmap::rowOf(key), kRows - 1);
+    return row * m_columns + column;
+}
+
+ccColor4B HeatmapLayer::colorFor(uint32_t count) const {
+    if (count == 0) return { 0, 0, 0, 0 };
+
+    // Yellow for the odd death, red where the level keeps killing
+    float heat = std::min(1.0f, std::log2(1.0f + count) / std::log2(1.0f + kSaturation));
+    return {
+        255,
+        static_cast<GLubyte>(220.0f * (1.0f - heat)),
+        0,
+        static_cast<GLubyte>(255.0f * (0.3f + 0.7f * heat))
+    };
+}
+
+void HeatmapLayer::record(CCPoint position) {
+    auto const& cell = m_heatmap.add(position.x, position.y);
+    m_dirty = true;
+
+    uint32_t texel = texelOf(cell.key);
+    m_counts[texel]++;
+    auto color = colorFor(m_counts[texel]);
+    if (std::memcmp(&color, &m_pixels[texel], sizeof(color)) == 0) return;
+
+    // The colors are fixed per count, so no other texel changes
+    m_pixels[texel] = color;
+    ccGLBindTexture2D(m_texture->getName());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, texel % m_columns, texel / m_columns, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &m_pixels[texel]);
+}
+
+void HeatmapLayer::save() {
+    if (!m_dirty) return;
+    if (m_heatmap.save(m_path)) {
+        m_dirty = false;
+    } else {
+        log::warn("Could not save heatmap to {}", m_path.string());
+    }
+}
+
+void HeatmapLayer::update(float dt) {
+    bool visible = !m_onlyWhilePaused || m_playLayer->m_isPaused;
+    if (this->isVisible() != visible) {
+        this->setVisible(visible);
+    }
+}
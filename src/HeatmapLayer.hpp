@@ -0,0 +1,40 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "DeathHeatmap.hpp"
+
+using namespace geode::prelude;
+
+// The level's death heatmap as one texture stretched over level space, inside the object layer so
+// it scrolls with the level. Each texel covers a few cells; a new death recolors and uploads just
+// the texel it landed in. Shown during play or only while paused, per the "heatmap" setting.
+class HeatmapLayer : public CCNode {
+public:
+    static constexpr uint32_t kMaxColumns = 2048;
+    static constexpr uint32_t kRows = 128;
+    // Texels at or above this many deaths are fully hot, the color scale is logarithmic below it
+    static constexpr uint32_t kSaturation = 100;
+
+    static HeatmapLayer* create(PlayLayer* playLayer, bool onlyWhilePaused);
+
+    void record(CCPoint position);
+    void save();
+    void update(float dt) override;
+
+private:
+    bool init(PlayLayer* playLayer, bool onlyWhilePaused);
+    uint32_t texelOf(uint32_t key) const;
+    ccColor4B colorFor(uint32_t count) const;
+
+    PlayLayer* m_playLayer = nullptr;
+    std::filesystem::path m_path;
+    DeathHeatmap m_heatmap;
+    bool m_dirty = false;
+    bool m_onlyWhilePaused = false;
+
+    uint32_t m_columns = 0;
+    uint32_t m_cellsPerTexel = 1;           // columns of cells summed into one texel column
+    std::vector<uint32_t> m_counts;         // per texel
+    std::vector<ccColor4B> m_pixels;
+    CCTexture2D* m_texture = nullptr;
+    CCSprite* m_sprite = nullptr;
+};
@@ -0,0 +1,257 @@
+#include "ParticleBurst.hpp"
+#include "Timeline.hpp"
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define BURST_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define BURST_NEON
+#endif
+
+namespace {
+    // Start time of padding lanes and retired particles, far enough out that none ever launch
+    constexpr float kNever = 1e30f;
+    constexpr float kNoFade = 1e30f;
+
+    float clamp01(float value) {
+        return std::min(std::max(value, 0.0f), 1.0f);
+    }
+
+    // Linear interpolation between the 257 samples of the burst's ease
+    float lookup(const float* table, float progress) {
+        float position = progress * ParticleBurst::kEaseSteps;
+        int index = static_cast<int>(std::min(position, ParticleBurst::kEaseSteps - 1.0f));
+        float fraction = position - static_cast<float>(index);
+        return table[index] + (table[index + 1] - table[index]) * fraction;
+    }
+
+}
+
+// Just enough of a 4-wide float vector for the kernel, named so it reads like the scalar code
+#if defined(BURST_SSE2)
+namespace simd {
+    using Vec = __m128;
+    using Mask = __m128;
+
+    Vec load(const float* data) { return _mm_loadu_ps(data); }
+    void store(float* data, Vec value) { _mm_storeu_ps(data, value); }
+    Vec splat(float value) { return _mm_set1_ps(value); }
+    Vec plus(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    Vec minus(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    Vec times(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    Vec clamp01(Vec value) { return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+
+    Mask isAlive(Vec age, Vec time, Vec finish) {
+        return _mm_and_ps(_mm_cmpge_ps(age, _mm_setzero_ps()), _mm_cmplt_ps(time, finish));
+    }
+    Vec keep(Mask mask, Vec value) { return _mm_and_ps(mask, value); }
+    size_t count(Mask mask) { return std::popcount(static_cast<unsigned>(_mm_movemask_ps(mask))); }
+
+    Vec lookup(const float* table, Vec progress) {
+        Vec position = times(progress, splat(ParticleBurst::kEaseSteps));
+        __m128i index = _mm_cvttps_epi32(_mm_min_ps(position, splat(ParticleBurst::kEaseSteps - 1.0f)));
+        Vec fraction = minus(position, _mm_cvtepi32_ps(index));
+
+        // No gather before AVX2, four scalar loads are still far cheaper than four pow() calls
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+        Vec from = _mm_setr_ps(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+        Vec to = _mm_setr_ps(table[lanes[0] + 1], table[lanes[1] + 1], table[lanes[2] + 1], table[lanes[3] + 1]);
+        return plus(from, times(minus(to, from), fraction));
+    }
+}
+#elif defined(BURST_NEON)
+namespace simd {
+    using Vec = float32x4_t;
+    using Mask = uint32x4_t;
+
+    Vec load(const float* data) { return vld1q_f32(data); }
+    void store(float* data, Vec value) { vst1q_f32(data, value); }
+    Vec splat(float value) { return vdupq_n_f32(value); }
+    Vec plus(Vec a, Vec b) { return vaddq_f32(a, b); }
+    Vec minus(Vec a, Vec b) { return vsubq_f32(a, b); }
+    Vec times(Vec a, Vec b) { return vmulq_f32(a, b); }
+    Vec clamp01(Vec value) { return vminq_f32(vmaxq_f32(value, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f)); }
+
+    Mask isAlive(Vec age, Vec time, Vec finish) {
+        return vandq_u32(vcgeq_f32(age, vdupq_n_f32(0.0f)), vcltq_f32(time, finish));
+    }
+    Vec keep(Mask mask, Vec value) { return vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(value))); }
+    size_t count(Mask mask) { return vaddvq_u32(vshrq_n_u32(mask, 31)); }
+
+    Vec lookup(const float* table, Vec progress) {
+        Vec position = times(progress, splat(ParticleBurst::kEaseSteps));
+        int32x4_t index = vcvtq_s32_f32(vminq_f32(position, splat(ParticleBurst::kEaseSteps - 1.0f)));
+        Vec fraction = minus(position, vcvtq_f32_s32(index));
+
+        int32_t lanes[4];
+        vst1q_s32(lanes, index);
+        float from[4] = { table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]] };
+        float to[4] = { table[lanes[0] + 1], table[lanes[1] + 1], table[lanes[2] + 1], table[lanes[3] + 1] };
+        Vec start = vld1q_f32(from);
+        return plus(start, times(minus(vld1q_f32(to), start), fraction));
+    }
+}
+#endif
+
+ParticleBurst::ParticleBurst(uint8_t layer, int zOrder, Ease ease, float rate) : m_layer(layer), m_zOrder(zOrder) {
+    for (size_t i = 0; i <= kEaseSteps; i++) {
+        m_easing[i] = Timeline::ease(ease, rate, static_cast<float>(i) / kEaseSteps);
+    }
+}
+
+void ParticleBurst::pad() {
+    // A whole lane group at a time, so the kernel never needs a scalar tail
+    auto grow = [](auto& values, auto value) {
+        values.insert(values.end(), kLanes, value);
+    };
+    grow(m_start, kNever);
+    grow(m_finish, kNever);
+    for (auto values : {
+        &m_inverseLife, &m_x, &m_deltaX, &m_y, &m_deltaY, &m_arc, &m_rotation, &m_spin, &m_scale,
+        &m_peakDelta, &m_endDelta, &m_peakTime, &m_inversePeak, &m_inverseRest, &m_inverseFade, &m_opacity,
+        &m_outX, &m_outY, &m_outRotation, &m_outScale, &m_outAlpha
+    }) {
+        grow(*values, 0.0f);
+    }
+    grow(m_detail, Quality::Low);
+    grow(m_colors, Color { 255, 255, 255 });
+    grow(m_origins, uint8_t(0));
+}
+
+void ParticleBurst::add(Particle const& particle) {
+    if (m_count == m_start.size()) {
+        pad();
+    }
+    size_t i = m_count++;
+
+    float life = std::max(particle.life, 0.0f);
+    m_start[i] = particle.start;
+    m_finish[i] = particle.start + life;
+    m_inverseLife[i] = life > 0.0f ? 1.0f / life : 0.0f;
+    m_x[i] = particle.x;
+    m_deltaX[i] = particle.toX - particle.x;
+    m_y[i] = particle.y;
+    m_deltaY[i] = particle.toY - particle.y;
+    m_arc[i] = particle.height * 4.0f;
+    m_rotation[i] = particle.rotation;
+    m_spin[i] = particle.spin;
+    m_opacity[i] = particle.opacity;
+    m_inverseFade[i] = particle.fade > 0.0f ? 1.0f / particle.fade : kNoFade;
+    m_detail[i] = particle.detail;
+    m_colors[i] = { particle.r, particle.g, particle.b };
+    m_origins[i] = particle.origin;
+
+    // Scale is two linear segments, launch to peak and peak to end; without a peak the first is empty
+    m_scale[i] = particle.scale;
+    if (particle.peakTime > 0.0f && particle.peakTime < life) {
+        m_peakTime[i] = particle.peakTime;
+        m_inversePeak[i] = 1.0f / particle.peakTime;
+        m_peakDelta[i] = particle.peakScale - particle.scale;
+        m_inverseRest[i] = 1.0f / (life - particle.peakTime);
+        m_endDelta[i] = particle.endScale - particle.peakScale;
+    } else {
+        m_peakTime[i] = 0.0f;
+        m_inversePeak[i] = 0.0f;
+        m_peakDelta[i] = 0.0f;
+        m_inverseRest[i] = m_inverseLife[i];
+        m_endDelta[i] = particle.endScale - particle.scale;
+    }
+
+    m_end = std::max(m_end, m_finish[i]);
+}
+
+void ParticleBurst::retireAbove(Quality quality) {
+    for (size_t i = 0; i < m_count; i++) {
+        if (m_detail[i] > quality) {
+            m_start[i] = kNever;
+            m_finish[i] = kNever;
+        }
+    }
+}
+
+void ParticleBurst::scaleTime(float factor) {
+    float inverse = 1.0f / factor;
+    for (size_t i = 0; i < m_count; i++) {
+        if (m_start[i] == kNever) continue;
+        m_start[i] *= factor;
+        m_finish[i] *= factor;
+        m_inverseLife[i] *= inverse;
+        m_peakTime[i] *= factor;
+        m_inversePeak[i] *= inverse;
+        m_inverseRest[i] *= inverse;
+        if (m_inverseFade[i] != kNoFade) {
+            m_inverseFade[i] *= inverse;
+        }
+    }
+    m_end *= factor;
+}
+
+size_t ParticleBurst::getMemoryUsage() const {
+    return sizeof(m_easing) + m_start.capacity() * (sizeof(float) * 23 + sizeof(Quality) + sizeof(Color) + sizeof(uint8_t));
+}
+
+// ===============================================================================================
+// KERNELS - Both must do the same operations in the same order, so they round alike
+
+size_t ParticleBurst::stepScalar(float time) {
+    size_t alive = 0;
+    for (size_t i = 0; i < m_count; i++) {
+        float age = time - m_start[i];
+        float progress = clamp01(age * m_inverseLife[i]);
+        float eased = lookup(m_easing, progress);
+
+        m_outX[i] = m_x[i] + m_deltaX[i] * eased;
+        m_outY[i] = m_y[i] + m_deltaY[i] * eased + m_arc[i] * (progress * (1.0f - progress));
+        m_outRotation[i] = m_rotation[i] + m_spin[i] * progress;
+
+        float grow = clamp01(age * m_inversePeak[i]);
+        float shrink = clamp01((age - m_peakTime[i]) * m_inverseRest[i]);
+        float scale = m_scale[i] + m_peakDelta[i] * grow + m_endDelta[i] * shrink;
+        float alpha = m_opacity[i] * clamp01((m_finish[i] - time) * m_inverseFade[i]);
+
+        bool live = age >= 0.0f && time < m_finish[i];
+        m_outScale[i] = live ? scale : 0.0f;
+        m_outAlpha[i] = live ? alpha : 0.0f;
+        alive += live;
+    }
+    return alive;
+}
+
+size_t ParticleBurst::step(float time) {
+#if defined(BURST_SSE2) || defined(BURST_NEON)
+    using namespace simd;
+
+    Vec now = splat(time);
+    Vec one = splat(1.0f);
+    size_t alive = 0;
+
+    for (size_t i = 0; i < m_count; i += kLanes) {
+        Vec age = minus(now, load(&m_start[i]));
+        Vec progress = clamp01(times(age, load(&m_inverseLife[i])));
+        Vec eased = lookup(m_easing, progress);
+
+        store(&m_outX[i], plus(load(&m_x[i]), times(load(&m_deltaX[i]), eased)));
+        Vec arc = times(load(&m_arc[i]), times(progress, minus(one, progress)));
+        store(&m_outY[i], plus(plus(load(&m_y[i]), times(load(&m_deltaY[i]), eased)), arc));
+        store(&m_outRotation[i], plus(load(&m_rotation[i]), times(load(&m_spin[i]), progress)));
+
+        Vec grow = clamp01(times(age, load(&m_inversePeak[i])));
+        Vec shrink = clamp01(times(minus(age, load(&m_peakTime[i])), load(&m_inverseRest[i])));
+        Vec scale = plus(plus(load(&m_scale[i]), times(load(&m_peakDelta[i]), grow)), times(load(&m_endDelta[i]), shrink));
+        Vec finish = load(&m_finish[i]);
+        Vec alpha = times(load(&m_opacity[i]), clamp01(times(minus(finish, now), load(&m_inverseFade[i]))));
+
+        Mask live = isAlive(age, now, finish);
+        store(&m_outScale[i], keep(live, scale));
+        store(&m_outAlpha[i], keep(live, alpha));
+        alive += count(live);
+    }
+    return alive;
+#else
+    return stepScalar(time);
+#endif
+}
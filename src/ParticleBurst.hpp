@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class Ease : uint8_t;
+enum class Quality : uint8_t;
+
+// Radial bursts of short-lived particles: each one launches from its start offset, travels to
+// its landing offset on the burst's ease (or an arc), spins, scales and fades out at the end.
+// Particle state lives in one float array per field, padded to whole SIMD lanes, so a frame is
+// a single pass over contiguous memory (SSE2 or NEON, scalar elsewhere). Easing comes from a
+// lookup table built once per burst instead of a pow() per particle per frame.
+class ParticleBurst {
+public:
+    struct Particle {
+        float start = 0.0f;         // seconds into the animation it launches at
+        float life = 1.0f;          // seconds from launch to removal
+        float x = 0.0f;             // launch offset from the animation origin
+        float y = 0.0f;
+        float toX = 0.0f;           // landing offset, reached at the end of its life
+        float toY = 0.0f;
+        float height = 0.0f;        // arc height on top of the eased path, like jumpTo
+        float rotation = 0.0f;      // degrees at launch
+        float spin = 0.0f;          // degrees turned over the whole life
+        float scale = 1.0f;         // at launch
+        float peakScale = 1.0f;     // reached after peakTime seconds
+        float peakTime = 0.0f;      // 0 goes straight from scale to endScale
+        float endScale = 1.0f;      // at the end of its life
+        float fade = 0.0f;          // seconds of fade out before removal
+        float opacity = 255.0f;
+        uint8_t r = 255;
+        uint8_t g = 255;
+        uint8_t b = 255;
+        Quality detail{};           // lowest tier that shows it
+        uint8_t origin = 0;         // which player's death its offsets are from
+    };
+
+    struct Color {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+    };
+
+    static constexpr size_t kLanes = 4;
+    static constexpr size_t kEaseSteps = 256;
+
+    ParticleBurst(uint8_t layer, int zOrder, Ease ease, float rate);
+
+    void add(Particle const& particle);
+    // Particles above the tier never launch; ones already in flight disappear
+    void retireAbove(Quality quality);
+    // Plays every particle `factor` times as long, launch times included
+    void scaleTime(float factor);
+
+    // Moves every particle to `time` and returns how many are alive. Dead particles come out
+    // with zero scale and alpha. step() uses the SIMD kernel, stepScalar() is the reference
+    // it has to match, kept for platforms without one and for checking the kernel against
+    // (tools/ParticleBurstCheck.cpp): to the bit unless the compiler fuses the scalar path into
+    // FMAs, as it may on aarch64, and to 1e-5 relative either way.
+    size_t step(float time);
+    size_t stepScalar(float time);
+
+    size_t size() const { return m_count; }
+    uint8_t getLayer() const { return m_layer; }
+    int getZOrder() const { return m_zOrder; }
+    float getEnd() const { return m_end; }
+    size_t getMemoryUsage() const;
+
+    // Output of the last step, one entry per particle
+    const float* getX() const { return m_outX.data(); }
+    const float* getY() const { return m_outY.data(); }
+    const float* getRotation() const { return m_outRotation.data(); }
+    const float* getScale() const { return m_outScale.data(); }
+    const float* getAlpha() const { return m_outAlpha.data(); }
+    const Color* getColors() const { return m_colors.data(); }
+    const uint8_t* getOrigins() const { return m_origins.data(); }
+
+private:
+    void pad();
+
+    uint8_t m_layer;
+    int m_zOrder;
+    float m_end = 0.0f;
+    size_t m_count = 0;
+    float m_easing[kEaseSteps + 1];
+
+    // Inputs, with every division done once when the particle is added
+    std::vector<float> m_start;
+    std::vector<float> m_finish;
+    std::vector<float> m_inverseLife;
+    std::vector<float> m_x;
+    std::vector<float> m_deltaX;
+    std::vector<float> m_y;
+    std::vector<float> m_deltaY;
+    std::vector<float> m_arc;           // 4 * height, since t(1 - t) peaks at 1/4
+    std::vector<float> m_rotation;
+    std::vector<float> m_spin;
+    std::vector<float> m_scale;
+    std::vector<float> m_peakDelta;
+    std::vector<float> m_endDelta;
+    std::vector<float> m_peakTime;
+    std::vector<float> m_inversePeak;
+    std::vector<float> m_inverseRest;
+    std::vector<float> m_inverseFade;
+    std::vector<float> m_opacity;
+    std::vector<Quality> m_detail;
+    std::vector<Color> m_colors;
+    std::vector<uint8_t> m_origins;
+
+    std::vector<float> m_outX;
+    std::vector<float> m_outY;
+    std::vector<float> m_outRotation;
+    std::vector<float> m_outScale;
+    std::vector<float> m_outAlpha;
+};
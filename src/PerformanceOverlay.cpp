@@ -0,0 +1,91 @@
+#include <Geode/Geode.hpp>
+#include "PerformanceOverlay.hpp"
+
+using namespace geode::prelude;
+
+namespace {
+    constexpr float kBarWidth = 14.0f;
+    constexpr float kBarHeight = 40.0f;
+}
+
+PerformanceOverlay* PerformanceOverlay::create(AnimationRunner* runner, float spawnMilliseconds) {
+    auto ret = new PerformanceOverlay();
+    if (ret->init(runner, spawnMilliseconds)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool PerformanceOverlay::init(AnimationRunner* runner, float spawnMilliseconds) {
+    if (!CCNode::init()) return false;
+
+    m_runner = runner;
+    m_spawnMilliseconds = spawnMilliseconds;
+
+    auto winSize = CCDirector::get()->getWinSize();
+    this->setPosition(ccp(8.0f, winSize.height - 8.0f));
+
+    m_label = CCLabelBMFont::create("", "chatFont.fnt");
+    m_label->setAnchorPoint(ccp(0.0f, 1.0f));
+    m_label->setScale(0.5f);
+    this->addChild(m_label);
+
+    for (size_t bucket = 0; bucket < kBucketCount; bucket++) {
+        float x = bucket * (kBarWidth + 2.0f);
+
+        auto background = CCLayerColor::create(ccc4(0, 0, 0, 120), kBarWidth, kBarHeight);
+        background->setPosition(ccp(x, -kBarHeight - 78.0f));
+        this->addChild(background);
+
+        m_bars[bucket] = CCLayerColor::create(ccc4(bucket < 4 ? 80 : 255, bucket < 4 ? 220 : 80, 80, 220), kBarWidth, 0.0f);
+        m_bars[bucket]->setPosition(background->getPosition());
+        this->addChild(m_bars[bucket]);
+
+        auto name = CCLabelBMFont::create(kBucketNames[bucket], "chatFont.fnt");
+        name->setScale(0.35f);
+        name->setPosition(ccp(x + kBarWidth / 2, -kBarHeight - 84.0f));
+        this->addChild(name);
+    }
+
+    refresh();
+    this->scheduleUpdate();
+    return true;
+}
+
+void PerformanceOverlay::update(float dt) {
+    if (m_runner->isFinished()) {
+        // Keep the final numbers on screen for a moment, then get out of the way
+        this->unscheduleUpdate();
+        refresh();
+        this->runAction(CCSequence::create(CCDelayTime::create(3.0f), CCRemoveSelf::create(), nullptr));
+        return;
+    }
+
+    float milliseconds = dt * 1000.0f;
+    size_t bucket = 0;
+    while (bucket < std::size(kBucketLimits) && milliseconds > kBucketLimits[bucket]) {
+        bucket++;
+    }
+    m_histogram[bucket]++;
+    m_frames++;
+    m_worstMilliseconds = std::max(m_worstMilliseconds, milliseconds);
+    m_peakFragments = std::max(m_peakFragments, m_runner->getActiveCount());
+
+    refresh();
+}
+
+void PerformanceOverlay::refresh() {
+    m_label->setString(fmt::format(
+        "Fragments: {} (peak {})\nCulled: {} ({} draws saved)\nParticles: {}\nTracks: {}\nSpawn frame: {:.2f} ms\nWorst frame: {:.2f} ms over {} frames",
+        m_runner->getActiveCount(), m_peakFragments, m_runner->getCulledCount(), m_runner->getSavedDraws(),
+        m_runner->getParticleCount(), m_runner->getTrackCount(),
+        m_spawnMilliseconds, m_worstMilliseconds, m_frames
+    ).c_str());
+
+    for (size_t bucket = 0; bucket < kBucketCount; bucket++) {
+        float share = m_frames ? static_cast<float>(m_histogram[bucket]) / m_frames : 0.0f;
+        m_bars[bucket]->setContentSize(CCSize(kBarWidth, kBarHeight * share));
+    }
+}
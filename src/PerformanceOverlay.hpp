@@ -0,0 +1,34 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include "AnimationRunner.hpp"
+
+using namespace geode::prelude;
+
+// Optional on-screen stats for a running death animation: live and culled fragments, particles, animated
+// tracks, how long the new-best frame spent creating the animation, and a histogram of frame
+// times for as long as the animation runs. Enabled with the "performance-overlay" setting.
+class PerformanceOverlay : public CCNode {
+public:
+    static PerformanceOverlay* create(AnimationRunner* runner, float spawnMilliseconds);
+
+    void update(float dt) override;
+
+private:
+    // Frame-time buckets, named after the refresh rate whose budget they fit in
+    static constexpr float kBucketLimits[] = { 1000.0f / 240, 1000.0f / 144, 1000.0f / 120, 1000.0f / 60, 1000.0f / 30 };
+    static constexpr const char* kBucketNames[] = { "240", "144", "120", "60", "30", "<30" };
+    static constexpr size_t kBucketCount = std::size(kBucketNames);
+
+    bool init(AnimationRunner* runner, float spawnMilliseconds);
+    void refresh();
+
+    Ref<AnimationRunner> m_runner;
+    float m_spawnMilliseconds = 0.0f;
+    float m_worstMilliseconds = 0.0f;
+    uint32_t m_frames = 0;
+    size_t m_peakFragments = 0;
+    std::array<uint32_t, kBucketCount> m_histogram = {};
+
+    CCLabelBMFont* m_label = nullptr;
+    std::array<CCLayerColor*, kBucketCount> m_bars = {};
+};
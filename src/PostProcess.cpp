@@ -0,0 +1,255 @@
+#include <Geode/Geode.hpp>
+#include "PostProcess.hpp"
+#include "Config.hpp"
+
+using namespace geode::prelude;
+
+namespace {
+    constexpr const char* kVertexShader = R"(
+attribute vec4 a_position;
+attribute vec2 a_texCoord;
+varying vec2 v_texCoord;
+
+void main() {
+    gl_Position = CC_MVPMatrix * a_position;
+    v_texCoord = a_texCoord;
+}
+)";
+
+    // Everything is worked out in points, so the effects look the same at any resolution
+    constexpr const char* kFragmentShader = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+varying vec2 v_texCoord;
+uniform sampler2D CC_Texture0;
+uniform vec2 u_size;
+uniform vec2 u_textureScale;
+uniform vec4 u_tint;
+uniform vec4 u_flash;
+uniform vec4 u_vignette;
+uniform vec3 u_zoom;
+uniform int u_shockwaveCount;
+uniform vec4 u_shockwaves[12];
+uniform vec3 u_shockwaveColors[12];
+
+void main() {
+    vec2 screen = v_texCoord / u_textureScale * u_size;
+    vec2 point = u_zoom.xy + (screen - u_zoom.xy) / u_zoom.z;
+
+    // The edge of each shockwave pushes the scene outwards, like a lens passing over it
+    vec2 source = point;
+    for (int i = 0; i < 12; i++) {
+        if (i >= u_shockwaveCount) break;
+        vec2 offset = point - u_shockwaves[i].xy;
+        float distance = length(offset);
+        float edge = 1.0 - clamp(abs(distance - u_shockwaves[i].z) / 24.0, 0.0, 1.0);
+        source -= offset / max(distance, 1.0) * edge * u_shockwaves[i].w * 12.0;
+    }
+    vec3 color = texture2D(CC_Texture0, clamp(source / u_size, 0.0, 1.0) * u_textureScale).rgb;
+
+    for (int i = 0; i < 12; i++) {
+        if (i >= u_shockwaveCount) break;
+        float distance = length(point - u_shockwaves[i].xy);
+        float inside = 1.0 - smoothstep(u_shockwaves[i].z * 0.9, u_shockwaves[i].z, distance);
+        color = mix(color, u_shockwaveColors[i], inside * u_shockwaves[i].w);
+    }
+
+    color = mix(color, u_tint.rgb, u_tint.a);
+    vec2 fromCenter = screen / u_size * 2.0 - 1.0;
+    color = mix(color, u_vignette.rgb, clamp(dot(fromCenter, fromCenter) * 0.5, 0.0, 1.0) * u_vignette.a);
+    color += u_flash.rgb * u_flash.a;
+    gl_FragColor = vec4(color, 1.0);
+}
+)";
+
+    ccColor4F toColor(ccColor3B color, float alpha) {
+        return { color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, alpha };
+    }
+}
+
+PostProcess* PostProcess::create(PlayLayer* playLayer) {
+    auto ret = new PostProcess();
+    if (ret->init(playLayer)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool PostProcess::init(PlayLayer* playLayer) {
+    if (!CCNode::init()) return false;
+
+    m_playLayer = playLayer;
+    m_enabled = Config::get().screenEffects && loadShader();
+    if (m_enabled) {
+        // Made with the level, so the first effect of a new best doesn't allocate a framebuffer
+        auto winSize = CCDirector::get()->getWinSize();
+        m_texture = CCRenderTexture::create(static_cast<int>(winSize.width), static_cast<int>(winSize.height));
+        m_enabled = m_texture != nullptr;
+    }
+    return true;
+}
+
+bool PostProcess::loadShader() {
+    auto cache = CCShaderCache::sharedShaderCache();
+    m_shader = cache->programForKey("post-process"_spr);
+    if (!m_shader) {
+        auto shader = new CCGLProgram();
+        if (!shader->initWithVertexShaderByteArray(kVertexShader, kFragmentShader)) {
+            log::warn("Could not compile the post-process shader, screen effects are off");
+            shader->release();
+            return false;
+        }
+        shader->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
+        shader->addAttribute(kCCAttributeNameTexCoord, kCCVertexAttrib_TexCoords);
+        if (!shader->link()) {
+            log::warn("Could not link the post-process shader, screen effects are off");
+            shader->release();
+            return false;
+        }
+        shader->updateUniforms();
+        cache->addProgram(shader, "post-process"_spr);
+        shader->release();
+        m_shader = shader;
+    }
+
+    auto program = m_shader->getProgram();
+    m_sizeLocation = glGetUniformLocation(program, "u_size");
+    m_textureScaleLocation = glGetUniformLocation(program, "u_textureScale");
+    m_tintLocation = glGetUniformLocation(program, "u_tint");
+    m_flashLocation = glGetUniformLocation(program, "u_flash");
+    m_vignetteLocation = glGetUniformLocation(program, "u_vignette");
+    m_zoomLocation = glGetUniformLocation(program, "u_zoom");
+    m_shockwaveCountLocation = glGetUniformLocation(program, "u_shockwaveCount");
+    m_shockwavesLocation = glGetUniformLocation(program, "u_shockwaves");
+    m_shockwaveColorsLocation = glGetUniformLocation(program, "u_shockwaveColors");
+    return true;
+}
+
+// ===============================================================================================
+// EFFECTS - Several of one kind combine the way their old stacked layers would have
+
+void PostProcess::clear() {
+    m_tint = {};
+    m_flash = {};
+    m_vignette = {};
+    m_zoom = 1.0f;
+    m_shockwaveCount = 0;
+}
+
+void PostProcess::addTint(ccColor3B color, float strength) {
+    // Later tints go over earlier ones
+    auto tint = toColor(color, strength);
+    float alpha = tint.a + m_tint.a * (1.0f - tint.a);
+    if (alpha <= 0.0f) return;
+    auto blend = [&](float over, float under) {
+        return (over * tint.a + under * m_tint.a * (1.0f - tint.a)) / alpha;
+    };
+    m_tint = { blend(tint.r, m_tint.r), blend(tint.g, m_tint.g), blend(tint.b, m_tint.b), alpha };
+}
+
+void PostProcess::addFlash(ccColor3B color, float strength) {
+    // Premultiplied, so flashes simply add up; a black or spent one adds nothing to draw
+    if (strength <= 0.0f || (color.r == 0 && color.g == 0 && color.b == 0)) return;
+    m_flash.r += color.r / 255.0f * strength;
+    m_flash.g += color.g / 255.0f * strength;
+    m_flash.b += color.b / 255.0f * strength;
+    m_flash.a = 1.0f;
+}
+
+void PostProcess::addVignette(ccColor3B color, float strength) {
+    if (strength > m_vignette.a) {
+        m_vignette = toColor(color, strength);
+    }
+}
+
+void PostProcess::addShockwave(Shockwave const& shockwave) {
+    if (m_shockwaveCount == kMaxShockwaves || shockwave.strength <= 0.0f) return;
+    m_shockwaves[m_shockwaveCount++] = shockwave;
+}
+
+void PostProcess::addZoom(CCPoint center, float factor) {
+    m_zoomCenter = center;
+    m_zoom *= std::max(factor, 0.01f);
+}
+
+void PostProcess::commit() {
+    bool active = m_enabled && (m_tint.a > 0.0f || m_flash.a > 0.0f || m_vignette.a > 0.0f
+        || m_shockwaveCount > 0 || m_zoom != 1.0f);
+
+    // Drawn from the scene, so there is nothing to do until the PlayLayer is in one
+    if (active && !this->getParent()) {
+        auto scene = m_playLayer->getParent();
+        if (scene) {
+            scene->addChild(this, m_playLayer->getZOrder());
+        } else {
+            active = false;
+        }
+    }
+    if (active == m_active) return;
+
+    // The PlayLayer is drawn by us while we are active, never twice
+    m_active = active;
+    m_playLayer->setVisible(!m_active);
+}
+
+// ===============================================================================================
+// DRAWING
+
+void PostProcess::visit() {
+    if (!m_active) return;
+
+    m_playLayer->setVisible(true);
+    m_texture->beginWithClear(0.0f, 0.0f, 0.0f, 1.0f);
+    m_playLayer->visit();
+    m_texture->end();
+    m_playLayer->setVisible(false);
+
+    CCNode::visit();
+}
+
+void PostProcess::draw() {
+    auto winSize = CCDirector::get()->getWinSize();
+    auto texture = m_texture->getSprite()->getTexture();
+    float maxS = texture->getMaxS();
+    float maxT = texture->getMaxT();
+
+    m_shader->use();
+    m_shader->setUniformsForBuiltins();
+    m_shader->setUniformLocationWith2f(m_sizeLocation, winSize.width, winSize.height);
+    m_shader->setUniformLocationWith2f(m_textureScaleLocation, maxS, maxT);
+    m_shader->setUniformLocationWith4f(m_tintLocation, m_tint.r, m_tint.g, m_tint.b, m_tint.a);
+    m_shader->setUniformLocationWith4f(m_flashLocation, m_flash.r, m_flash.g, m_flash.b, m_flash.a);
+    m_shader->setUniformLocationWith4f(m_vignetteLocation, m_vignette.r, m_vignette.g, m_vignette.b, m_vignette.a);
+    m_shader->setUniformLocationWith3f(m_zoomLocation, m_zoomCenter.x, m_zoomCenter.y, m_zoom);
+    m_shader->setUniformLocationWith1i(m_shockwaveCountLocation, static_cast<GLint>(m_shockwaveCount));
+
+    GLfloat shockwaves[kMaxShockwaves * 4] = {};
+    GLfloat colors[kMaxShockwaves * 3] = {};
+    for (size_t i = 0; i < m_shockwaveCount; i++) {
+        auto const& wave = m_shockwaves[i];
+        shockwaves[i * 4] = wave.center.x;
+        shockwaves[i * 4 + 1] = wave.center.y;
+        shockwaves[i * 4 + 2] = wave.radius;
+        shockwaves[i * 4 + 3] = wave.strength;
+        colors[i * 3] = wave.color.r / 255.0f;
+        colors[i * 3 + 1] = wave.color.g / 255.0f;
+        colors[i * 3 + 2] = wave.color.b / 255.0f;
+    }
+    m_shader->setUniformLocationWith4fv(m_shockwavesLocation, shockwaves, kMaxShockwaves);
+    m_shader->setUniformLocationWith3fv(m_shockwaveColorsLocation, colors, kMaxShockwaves);
+
+    // One opaque quad over the whole screen, the texture already holds the scene behind it
+    GLfloat vertices[] = { 0.0f, 0.0f, winSize.width, 0.0f, 0.0f, winSize.height, winSize.width, winSize.height };
+    GLfloat texCoords[] = { 0.0f, 0.0f, maxS, 0.0f, 0.0f, maxT, maxS, maxT };
+    ccGLBindTexture2D(texture->getName());
+    ccGLBlendFunc(GL_ONE, GL_ZERO);
+    ccGLEnableVertexAttribs(kCCVertexAttribFlag_Position | kCCVertexAttribFlag_TexCoords);
+    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    CC_INCREMENT_GL_DRAWS(1);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include <array>
+
+using namespace geode::prelude;
+
+// The full-screen effects of the death animations in a single pass. While any effect is on, the
+// PlayLayer is rendered once into a texture and drawn back through one shader that applies the
+// tint, vignette, shockwaves, flash and zoom together, instead of each being its own blended
+// full-screen quad. Lives in the scene right above the PlayLayer, which it hides meanwhile.
+class PostProcess : public CCNode {
+public:
+    static constexpr size_t kMaxShockwaves = 12;
+
+    struct Shockwave {
+        CCPoint center;
+        float radius;
+        float strength;     // 0 to 1, opacity of its fill and how hard its edge bends the scene
+        ccColor3B color;
+    };
+
+    static PostProcess* create(PlayLayer* playLayer);
+
+    // Effects are gathered again every frame: clear(), add what is running, then commit()
+    void clear();
+    void addTint(ccColor3B color, float strength);
+    void addFlash(ccColor3B color, float strength);
+    void addVignette(ccColor3B color, float strength);
+    void addShockwave(Shockwave const& shockwave);
+    void addZoom(CCPoint center, float factor);
+    void commit();
+
+    void visit() override;
+    void draw() override;
+
+private:
+    bool init(PlayLayer* playLayer);
+    bool loadShader();
+
+    PlayLayer* m_playLayer = nullptr;
+    Ref<CCRenderTexture> m_texture;
+    CCGLProgram* m_shader = nullptr;
+    bool m_enabled = false;
+    bool m_active = false;
+
+    ccColor4F m_tint = {};
+    ccColor4F m_flash = {};
+    ccColor4F m_vignette = {};
+    CCPoint m_zoomCenter;
+    float m_zoom = 1.0f;
+    size_t m_shockwaveCount = 0;
+    std::array<Shockwave, kMaxShockwaves> m_shockwaves = {};
+
+    GLint m_sizeLocation = -1;
+    GLint m_textureScaleLocation = -1;
+    GLint m_tintLocation = -1;
+    GLint m_flashLocation = -1;
+    GLint m_vignetteLocation = -1;
+    GLint m_zoomLocation = -1;
+    GLint m_shockwaveCountLocation = -1;
+    GLint m_shockwavesLocation = -1;
+    GLint m_shockwaveColorsLocation = -1;
+};
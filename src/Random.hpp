@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Seedable xoshiro128+ generator for the death animations. Each animation owns one, so the
+// same seed rebuilds the same animation and nothing is shared with the game's rand().
+// Floats are produced in blocks, which keeps the generator loop tight and easy to time.
+class Random {
+public:
+    explicit Random(uint64_t seed) {
+        // splitmix64 spreads even small seeds (level IDs, attempt counts) over the whole state
+        for (uint32_t& word : m_state) {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+        }
+    }
+
+    static uint64_t seedFor(int levelID, int attempt) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(levelID)) << 32) | static_cast<uint32_t>(attempt);
+    }
+
+    uint32_t nextU32() {
+        uint32_t result = m_state[0] + m_state[3];
+        uint32_t t = m_state[1] << 9;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = (m_state[3] << 11) | (m_state[3] >> 21);
+        return result;
+    }
+
+    // Uniform in [0, 1), from the top 24 bits so every value is exact in a float
+    void fill(float* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = static_cast<float>(nextU32() >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+
+    float next() {
+        if (m_index == kBlockSize) {
+            fill(m_block, kBlockSize);
+            m_index = 0;
+        }
+        return m_block[m_index++];
+    }
+
+private:
+    static constexpr size_t kBlockSize = 256;
+
+    uint32_t m_state[4];
+    float m_block[kBlockSize];
+    size_t m_index = kBlockSize;
+};
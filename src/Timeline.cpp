@@ -0,0 +1,341 @@
+#include "Timeline.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// ===============================================================================================
+// SAMPLING
+
+float Timeline::ease(Ease ease, float rate, float progress) {
+    switch (ease) {
+        case Ease::In:
+            return powf(progress, rate);
+        case Ease::Out:
+            return powf(progress, 1.0f / rate);
+        case Ease::InOut:
+            progress *= 2.0f;
+            if (progress < 1.0f) {
+                return 0.5f * powf(progress, rate);
+            }
+            return 1.0f - 0.5f * powf(2.0f - progress, rate);
+        default:
+            return progress;
+    }
+}
+
+float Timeline::evaluate(size_t fragment, Channel channel, float time, uint32_t& cursor) const {
+    size_t track = fragment * ChannelCount + channel;
+    const Key* keys = m_keys.data() + m_trackOffsets[track];
+    uint32_t count = m_trackOffsets[track + 1] - m_trackOffsets[track];
+
+    while (cursor + 1 < count && keys[cursor + 1].time <= time) {
+        cursor++;
+    }
+    if (cursor + 1 >= count || time <= keys[cursor].time) {
+        return keys[cursor].value;
+    }
+
+    const Key& from = keys[cursor];
+    const Key& to = keys[cursor + 1];
+    float progress = (time - from.time) / (to.time - from.time);
+    float value = from.value + (to.value - from.value) * ease(to.ease, to.rate, progress);
+    if (to.ease == Ease::Arc) {
+        value += to.rate * 4.0f * progress * (1.0f - progress);
+    }
+    return value;
+}
+
+float Timeline::sample(size_t fragment, Channel channel, float time) const {
+    size_t track = fragment * ChannelCount + channel;
+    auto first = m_keys.begin() + m_trackOffsets[track];
+    auto last = m_keys.begin() + m_trackOffsets[track + 1];
+    auto next = std::upper_bound(first, last, time, [](float t, const Key& key) { return t < key.time; });
+
+    uint32_t cursor = next == first ? 0 : static_cast<uint32_t>(next - first - 1);
+    return evaluate(fragment, channel, time, cursor);
+}
+
+void Timeline::scaleTo(float duration) {
+    if (m_duration <= 0.0f || duration <= 0.0f) return;
+    float factor = duration / m_duration;
+    for (auto& key : m_keys) {
+        key.time *= factor;
+    }
+    for (auto& fragment : m_fragments) {
+        fragment.start *= factor;
+        fragment.end *= factor;
+        fragment.hidden *= factor;
+        fragment.settled *= factor;
+    }
+    for (auto& burst : m_bursts) {
+        burst.scaleTime(factor);
+    }
+    m_duration = duration;
+}
+
+void Timeline::removeFragments(bool (*predicate)(Fragment const& fragment)) {
+    size_t kept = 0;
+    size_t keys = 0;
+    for (size_t fragment = 0; fragment < m_fragments.size(); fragment++) {
+        if (predicate(m_fragments[fragment])) continue;
+
+        // Tracks move down in order, so each one's keys land at or before where they were.
+        // Until the first removal they stay put; std::copy can't start inside its own source
+        for (int channel = 0; channel < ChannelCount; channel++) {
+            size_t track = fragment * ChannelCount + channel;
+            uint32_t first = m_trackOffsets[track];
+            uint32_t last = m_trackOffsets[track + 1];
+            m_trackOffsets[kept * ChannelCount + channel] = static_cast<uint32_t>(keys);
+            if (keys != first) {
+                std::copy(m_keys.begin() + first, m_keys.begin() + last, m_keys.begin() + keys);
+            }
+            keys += last - first;
+        }
+        m_fragments[kept++] = m_fragments[fragment];
+    }
+    m_fragments.resize(kept);
+    m_keys.resize(keys);
+    m_trackOffsets.resize(kept * ChannelCount + 1);
+    m_trackOffsets.back() = static_cast<uint32_t>(keys);
+}
+
+size_t Timeline::getPeakCount(Target target) const {
+    // Sweep over spawn and retire times; a retire at the same time as a spawn comes first
+    std::vector<std::pair<float, int>> events;
+    for (auto const& fragment : m_fragments) {
+        if (fragment.target != target) continue;
+        events.push_back({ fragment.start, 1 });
+        events.push_back({ std::min(fragment.end, fragment.hidden), -1 });
+    }
+    std::sort(events.begin(), events.end());
+
+    int peak = 0;
+    int live = 0;
+    for (auto const& [time, change] : events) {
+        live += change;
+        peak = std::max(peak, live);
+    }
+    return static_cast<size_t>(peak);
+}
+
+float Timeline::getLastKeyTime(size_t fragment, Channel channel) const {
+    size_t track = fragment * ChannelCount + channel;
+    return m_keys[m_trackOffsets[track + 1] - 1].time;
+}
+
+float Timeline::getHiddenTime(size_t fragment, Channel channel) const {
+    // The start of the run of zero keys the track ends on, if it ends on zero at all
+    size_t track = fragment * ChannelCount + channel;
+    size_t first = m_trackOffsets[track];
+    size_t key = m_trackOffsets[track + 1];
+    while (key > first && m_keys[key - 1].value == 0.0f) {
+        key--;
+    }
+    if (key == m_trackOffsets[track + 1]) return std::numeric_limits<float>::infinity();
+    return m_keys[key].time;
+}
+
+// ===============================================================================================
+// BUILDING
+
+uint8_t TimelineBuilder::addLayer(int zOrder) {
+    m_timeline.m_layers.push_back(zOrder);
+    return static_cast<uint8_t>(m_timeline.m_layers.size() - 1);
+}
+
+TimelineBuilder::FragmentBuilder TimelineBuilder::add(Timeline::Target target, uint8_t layer, int zOrder, State const& state) {
+    uint32_t index = static_cast<uint32_t>(m_timeline.m_fragments.size());
+    m_timeline.m_fragments.push_back({
+        target, layer, 0, Quality::Low, Effect::None, false, 0, zOrder,
+        std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::infinity(), 0.0f,
+        1.0f, 1.0f
+    });
+
+    float initial[Timeline::ChannelCount] = {
+        state.x, state.y, state.scale, state.rotation,
+        static_cast<float>(state.r), static_cast<float>(state.g), static_cast<float>(state.b),
+        static_cast<float>(state.opacity)
+    };
+    for (int channel = 0; channel < Timeline::ChannelCount; channel++) {
+        Timeline::Key key = { 0.0f, initial[channel], 1.0f, Ease::Linear };
+        m_lastKeys.push_back(key);
+        m_pending.push_back({ index * Timeline::ChannelCount + channel, key });
+    }
+
+    return FragmentBuilder(*this, index);
+}
+
+ParticleBurst& TimelineBuilder::addBurst(uint8_t layer, int zOrder, Ease ease, float rate) {
+    return m_timeline.m_bursts.emplace_back(layer, zOrder, ease, rate);
+}
+
+void TimelineBuilder::push(uint32_t track, Timeline::Key key) {
+    m_lastKeys[track] = key;
+    m_pending.push_back({ track, key });
+    m_timeline.m_fragments[track / Timeline::ChannelCount].animated |= 1 << (track % Timeline::ChannelCount);
+}
+
+Timeline TimelineBuilder::build() {
+    Timeline& timeline = m_timeline;
+    size_t trackCount = timeline.m_fragments.size() * Timeline::ChannelCount;
+
+    // Counting sort by track keeps each track's keys in insertion (= time) order
+    timeline.m_trackOffsets.assign(trackCount + 1, 0);
+    for (auto& pending : m_pending) {
+        timeline.m_trackOffsets[pending.track + 1]++;
+    }
+    for (size_t track = 0; track < trackCount; track++) {
+        timeline.m_trackOffsets[track + 1] += timeline.m_trackOffsets[track];
+    }
+
+    std::vector<uint32_t> fill(timeline.m_trackOffsets.begin(), timeline.m_trackOffsets.end() - 1);
+    timeline.m_keys.resize(m_pending.size());
+    for (auto& pending : m_pending) {
+        timeline.m_keys[fill[pending.track]++] = pending.key;
+    }
+
+    timeline.m_duration = 0.0f;
+    for (size_t fragment = 0; fragment < timeline.m_fragments.size(); fragment++) {
+        auto& desc = timeline.m_fragments[fragment];
+        // A fragment that never moves is there from the start
+        if (!std::isfinite(desc.start)) {
+            desc.start = 0.0f;
+        }
+        desc.start = std::min(desc.start, desc.end);
+        float end = desc.end;
+        if (!std::isfinite(end)) {
+            end = 0.0f;
+            for (int channel = 0; channel < Timeline::ChannelCount; channel++) {
+                end = std::max(end, m_lastKeys[fragment * Timeline::ChannelCount + channel].time);
+            }
+        }
+        timeline.m_duration = std::max(timeline.m_duration, end);
+
+        desc.settled = 0.0f;
+        for (auto channel : { Timeline::X, Timeline::Y, Timeline::Scale, Timeline::Rotation }) {
+            desc.settled = std::max(desc.settled, timeline.getLastKeyTime(fragment, channel));
+        }
+        // The player is only borrowed, it keeps whatever the animation leaves it with
+        if (desc.target != Timeline::Target::Player) {
+            desc.hidden = std::min(timeline.getHiddenTime(fragment, Timeline::Opacity), timeline.getHiddenTime(fragment, Timeline::Scale));
+        }
+    }
+    for (auto const& burst : timeline.m_bursts) {
+        timeline.m_duration = std::max(timeline.m_duration, burst.getEnd());
+    }
+
+    m_pending.clear();
+    m_lastKeys.clear();
+
+    Timeline result = std::move(m_timeline);
+    m_timeline = Timeline();
+    return result;
+}
+
+// ===============================================================================================
+// FRAGMENT BUILDER
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::wait(float seconds) {
+    m_cursor += seconds;
+    return *this;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::after(float seconds) {
+    m_offset = seconds;
+    return *this;
+}
+
+float TimelineBuilder::FragmentBuilder::current(Timeline::Channel channel) const {
+    return m_builder.m_lastKeys[m_index * Timeline::ChannelCount + channel].value;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::tween(Timeline::Channel channel, float duration, float value, Ease ease, float rate) {
+    uint32_t track = m_index * Timeline::ChannelCount + channel;
+    Timeline::Key last = m_builder.m_lastKeys[track];
+
+    // A tween never starts before the previous one on the same channel has finished
+    float start = std::max(m_cursor + m_offset, last.time);
+    m_offset = 0.0f;
+
+    // Nothing shows a fragment before its first tween, so it is only spawned then
+    auto& desc = m_builder.m_timeline.m_fragments[m_index];
+    desc.start = std::min(desc.start, start);
+
+    if (start > last.time) {
+        m_builder.push(track, { start, last.value, 1.0f, Ease::Linear });
+    }
+    m_builder.push(track, { start + duration, value, rate, ease });
+    return *this;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::moveTo(float duration, float x, float y, Ease ease, float rate) {
+    float offset = m_offset;
+    tween(Timeline::X, duration, x, ease, rate);
+    m_offset = offset;
+    return tween(Timeline::Y, duration, y, ease, rate);
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::moveBy(float duration, float dx, float dy, Ease ease, float rate) {
+    return moveTo(duration, current(Timeline::X) + dx, current(Timeline::Y) + dy, ease, rate);
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::jumpTo(float duration, float x, float y, float height) {
+    float offset = m_offset;
+    tween(Timeline::X, duration, x, Ease::Linear, 1.0f);
+    m_offset = offset;
+    return tween(Timeline::Y, duration, y, Ease::Arc, height);
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::scaleTo(float duration, float scale, Ease ease, float rate) {
+    return tween(Timeline::Scale, duration, scale, ease, rate);
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::rotateBy(float duration, float degrees) {
+    return tween(Timeline::Rotation, duration, current(Timeline::Rotation) + degrees, Ease::Linear, 1.0f);
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::tintTo(float duration, uint8_t r, uint8_t g, uint8_t b) {
+    float offset = m_offset;
+    tween(Timeline::Red, duration, r, Ease::Linear, 1.0f);
+    m_offset = offset;
+    tween(Timeline::Green, duration, g, Ease::Linear, 1.0f);
+    m_offset = offset;
+    return tween(Timeline::Blue, duration, b, Ease::Linear, 1.0f);
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::fadeTo(float duration, float opacity) {
+    return tween(Timeline::Opacity, duration, opacity, Ease::Linear, 1.0f);
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::setScaleXY(float scaleX, float scaleY) {
+    auto& desc = m_builder.m_timeline.m_fragments[m_index];
+    desc.scaleX = scaleX;
+    desc.scaleY = scaleY;
+    return *this;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::setDetail(Quality detail) {
+    m_builder.m_timeline.m_fragments[m_index].detail = detail;
+    return *this;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::setCentered() {
+    m_builder.m_timeline.m_fragments[m_index].centered = true;
+    return *this;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::setEffect(Effect effect) {
+    m_builder.m_timeline.m_fragments[m_index].effect = effect;
+    return *this;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::setOrigin(uint8_t origin) {
+    m_builder.m_timeline.m_fragments[m_index].origin = origin;
+    return *this;
+}
+
+TimelineBuilder::FragmentBuilder& TimelineBuilder::FragmentBuilder::remove() {
+    m_builder.m_timeline.m_fragments[m_index].end = m_cursor;
+    return *this;
+}
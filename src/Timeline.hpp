@@ -0,0 +1,205 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include "ParticleBurst.hpp"
+
+// Keyframe timeline for the death animations.
+// Every fragment owns one track per channel; all keys live in one flat array, so a whole
+// animation is a handful of allocations and can be sampled at any time without cocos2d.
+// Positions are offsets from the animation origin (the death position), and the player's
+// rotation is relative to the one it died with, so a timeline can be built before the death.
+// In dual mode there is an origin per player, each fragment and particle names its own.
+
+enum class Ease : uint8_t {
+    Linear,
+    In,     // CCEaseIn
+    Out,    // CCEaseOut
+    InOut,  // CCEaseInOut
+    Arc     // CCJumpTo with one jump, `rate` is the jump height
+};
+
+// Quality tiers. A fragment's detail is the lowest tier that still shows it.
+enum class Quality : uint8_t {
+    Low,
+    Medium,
+    High
+};
+
+// Full-screen effects, applied together in one post-process pass (see PostProcess)
+enum class Effect : uint8_t {
+    None,
+    Tint,       // color and opacity blended over the scene, like a full-screen color layer
+    Flash,      // color times opacity added to the scene
+    Vignette,   // color and opacity darkening towards the screen edges
+    Shockwave,  // a disc of radius scale * half a fragment, tinted by color and opacity, bending the scene at its edge
+    Zoom        // the scene scaled by scale around the fragment's position
+};
+
+class Timeline {
+public:
+    static constexpr uint8_t kMaxOrigins = 2;   // one per player in dual mode
+
+    enum Channel : uint8_t {
+        X,
+        Y,
+        Scale,
+        Rotation,
+        Red,
+        Green,
+        Blue,
+        Opacity,
+        ChannelCount
+    };
+
+    enum class Target : uint8_t {
+        Fragment,   // pooled sprite inside one of the animation's batches
+        Player,     // the player icon itself
+        Overlay,    // full-screen color layer, only color and opacity apply
+        Effect      // no node, its channels drive a post-process effect
+    };
+
+    struct Key {
+        float time;
+        float value;
+        float rate;
+        Ease ease;
+    };
+
+    struct Fragment {
+        Target target;
+        uint8_t layer;
+        uint8_t animated;   // bitmask of channels with more than one key
+        Quality detail;
+        Effect effect;      // which effect an Effect target drives
+        bool centered;      // y is measured from the middle of the screen, not the origin
+        uint8_t origin;     // which player's death it is placed from, 0 unless in dual mode
+        int zOrder;
+        float start;        // when its first tween begins, it is not in the scene before that
+        float end;
+        float hidden;       // transparent or scaled to nothing from here on, so it can retire early
+        float settled;      // its position, scale and rotation stop changing here
+        float scaleX;
+        float scaleY;
+    };
+
+    static float ease(Ease ease, float rate, float progress);
+
+    // Samples one track. `cursor` caches the current segment and only moves forward,
+    // so calling this every frame with increasing times is O(1) per track.
+    float evaluate(size_t fragment, Channel channel, float time, uint32_t& cursor) const;
+    float sample(size_t fragment, Channel channel, float time) const;
+
+    // Stretches or squeezes the whole animation, keys, spawns and bursts alike, to `duration`
+    void scaleTo(float duration);
+    // Drops the fragments that match, with their keys; the duration stays what it was
+    void removeFragments(bool (*predicate)(Fragment const& fragment));
+
+    bool isAnimated(size_t fragment, Channel channel) const {
+        return m_fragments[fragment].animated & (1 << channel);
+    }
+
+    const std::vector<Fragment>& getFragments() const { return m_fragments; }
+    const std::vector<int>& getLayers() const { return m_layers; }
+    const std::vector<ParticleBurst>& getBursts() const { return m_bursts; }
+    std::vector<ParticleBurst>& getBursts() { return m_bursts; }
+    size_t getKeyCount() const { return m_keys.size(); }
+    size_t getPeakCount(Target target) const;   // most fragments of this target alive at once, hidden ones not counted
+    float getDuration() const { return m_duration; }
+    size_t getMemoryUsage() const {
+        return m_fragments.capacity() * sizeof(Fragment)
+            + m_trackOffsets.capacity() * sizeof(uint32_t)
+            + m_keys.capacity() * sizeof(Key)
+            + m_layers.capacity() * sizeof(int)
+            + std::accumulate(m_bursts.begin(), m_bursts.end(), size_t(0), [](size_t total, ParticleBurst const& burst) {
+                return total + burst.getMemoryUsage();
+            });
+    }
+
+private:
+    friend class TimelineBuilder;
+
+    float getLastKeyTime(size_t fragment, Channel channel) const;
+    float getHiddenTime(size_t fragment, Channel channel) const;
+
+    std::vector<Fragment> m_fragments;
+    std::vector<uint32_t> m_trackOffsets;   // fragments * ChannelCount + 1 entries into m_keys
+    std::vector<Key> m_keys;
+    std::vector<int> m_layers;              // Z-order of each fragment batch
+    std::vector<ParticleBurst> m_bursts;    // particles drawn straight from arrays, not as fragments
+    float m_duration = 0.0f;
+};
+
+// Builds a Timeline with the same vocabulary as the cocos2d actions it replaces.
+// Tweens start at the fragment's cursor and run side by side like a CCSpawn;
+// wait() advances the cursor like CCDelayTime (or the end of a CCSpawn) in a CCSequence.
+class TimelineBuilder {
+public:
+    struct State {
+        float x = 0.0f;
+        float y = 0.0f;
+        float scale = 1.0f;
+        float rotation = 0.0f;
+        uint8_t r = 255;
+        uint8_t g = 255;
+        uint8_t b = 255;
+        uint8_t opacity = 255;
+    };
+
+    class FragmentBuilder {
+    public:
+        FragmentBuilder& wait(float seconds);
+        FragmentBuilder& after(float seconds);   // delays only the next tween, like a CCDelayTime nested in a CCSpawn
+
+        FragmentBuilder& moveTo(float duration, float x, float y, Ease ease = Ease::Linear, float rate = 1.0f);
+        FragmentBuilder& moveBy(float duration, float dx, float dy, Ease ease = Ease::Linear, float rate = 1.0f);
+        FragmentBuilder& jumpTo(float duration, float x, float y, float height);
+        FragmentBuilder& scaleTo(float duration, float scale, Ease ease = Ease::Linear, float rate = 1.0f);
+        FragmentBuilder& rotateBy(float duration, float degrees);
+        FragmentBuilder& tintTo(float duration, uint8_t r, uint8_t g, uint8_t b);
+        FragmentBuilder& fadeTo(float duration, float opacity);
+        FragmentBuilder& fadeIn(float duration) { return fadeTo(duration, 255.0f); }
+        FragmentBuilder& fadeOut(float duration) { return fadeTo(duration, 0.0f); }
+        FragmentBuilder& setScaleXY(float scaleX, float scaleY);
+        FragmentBuilder& setDetail(Quality detail);
+        FragmentBuilder& setCentered();
+        FragmentBuilder& setEffect(Effect effect);
+        FragmentBuilder& setOrigin(uint8_t origin);
+
+        // CCRemoveSelf: the fragment is retired at the cursor
+        FragmentBuilder& remove();
+
+        float time() const { return m_cursor; }
+
+    private:
+        friend class TimelineBuilder;
+        FragmentBuilder(TimelineBuilder& builder, uint32_t index) : m_builder(builder), m_index(index) {}
+
+        FragmentBuilder& tween(Timeline::Channel channel, float duration, float value, Ease ease, float rate);
+        float current(Timeline::Channel channel) const;
+
+        TimelineBuilder& m_builder;
+        uint32_t m_index;
+        float m_cursor = 0.0f;
+        float m_offset = 0.0f;
+    };
+
+    uint8_t addLayer(int zOrder);
+    FragmentBuilder add(Timeline::Target target, uint8_t layer, int zOrder, State const& state);
+    ParticleBurst& addBurst(uint8_t layer, int zOrder, Ease ease, float rate);
+
+    Timeline build();
+
+private:
+    struct PendingKey {
+        uint32_t track;
+        Timeline::Key key;
+    };
+
+    void push(uint32_t track, Timeline::Key key);
+
+    Timeline m_timeline;
+    std::vector<PendingKey> m_pending;
+    std::vector<Timeline::Key> m_lastKeys;   // last key of every track, for holds and relative tweens
+};
@@ -0,0 +1,66 @@
+#include "TombstoneIndex.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace {
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    bool byX(Tombstone const& a, Tombstone const& b) {
+        return a.x < b.x;
+    }
+}
+
+TombstoneIndex TombstoneIndex::load(std::filesystem::path const& path, size_t size) {
+    TombstoneIndex index;
+    if (size < sizeof(Header)) return index;
+
+    std::ifstream file(path, std::ios::binary);
+    Header header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return index;
+    if (header.magic != kMagic || header.version != kVersion) return index;
+
+    // One read for the whole file, the records need no parsing
+    size_t count = (size - sizeof(Header)) / sizeof(Tombstone);
+    index.m_tombstones.resize(count);
+    file.read(reinterpret_cast<char*>(index.m_tombstones.data()), count * sizeof(Tombstone));
+    index.m_tombstones.resize(static_cast<size_t>(file.gcount()) / sizeof(Tombstone));
+
+    std::sort(index.m_tombstones.begin(), index.m_tombstones.end(), byX);
+    return index;
+}
+
+bool TombstoneIndex::append(std::filesystem::path const& path, Tombstone const& tombstone) {
+    std::error_code error;
+    bool exists = std::filesystem::exists(path, error);
+    if (!exists) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    } else {
+        // Cut a torn record off first, or every record after it would be read misaligned
+        auto size = std::filesystem::file_size(path, error);
+        if (!error && size >= sizeof(Header) && (size - sizeof(Header)) % sizeof(Tombstone) != 0) {
+            std::filesystem::resize_file(path, size - (size - sizeof(Header)) % sizeof(Tombstone), error);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    if (!file) return false;
+    if (!exists) {
+        Header header = { kMagic, kVersion };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    file.write(reinterpret_cast<const char*>(&tombstone), sizeof(tombstone));
+    return static_cast<bool>(file);
+}
+
+void TombstoneIndex::insert(Tombstone const& tombstone) {
+    m_tombstones.insert(std::upper_bound(m_tombstones.begin(), m_tombstones.end(), tombstone, byX), tombstone);
+}
+
+std::vector<Tombstone>::const_iterator TombstoneIndex::lowerBound(float x) const {
+    return std::lower_bound(m_tombstones.begin(), m_tombstones.end(), x, [](Tombstone const& tombstone, float x) {
+        return tombstone.x < x;
+    });
+}
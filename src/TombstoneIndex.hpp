@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// One recorded death, in level coordinates. This is also the on-disk record, after a
+// small header, so a file is read straight into memory without parsing.
+struct Tombstone {
+    enum Flags : uint8_t {
+        NewBest = 1 << 0
+    };
+
+    float x;
+    float y;
+    uint8_t flags;
+    uint8_t percent;
+    uint16_t reserved;
+};
+static_assert(sizeof(Tombstone) == 12);
+
+// Every tombstone of one level, sorted by x so the ones inside the camera window are a binary
+// search and a short scan away. The file behind it is append-only: a death adds one record
+// and never rewrites the others, so recording stays O(1) however many deaths a level has.
+class TombstoneIndex {
+public:
+    static constexpr uint32_t kMagic = 0x424D4F54;   // "TOMB"
+    static constexpr uint32_t kVersion = 1;
+
+    // Reads the first `size` bytes of the file, a record torn by a crash mid-append is dropped
+    static TombstoneIndex load(std::filesystem::path const& path, size_t size);
+    static bool append(std::filesystem::path const& path, Tombstone const& tombstone);
+
+    void insert(Tombstone const& tombstone);
+
+    // Calls `visit` for up to `limit` tombstones inside the window, left to right
+    template <class F>
+    size_t query(float left, float right, float bottom, float top, size_t limit, F&& visit) const {
+        size_t found = 0;
+        auto it = lowerBound(left);
+        for (; it != m_tombstones.end() && it->x <= right && found < limit; ++it) {
+            if (it->y < bottom || it->y > top) continue;
+            visit(*it);
+            found++;
+        }
+        return found;
+    }
+
+    size_t size() const { return m_tombstones.size(); }
+
+private:
+    std::vector<Tombstone>::const_iterator lowerBound(float x) const;
+
+    std::vector<Tombstone> m_tombstones;
+};
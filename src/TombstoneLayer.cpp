@@ -0,0 +1,132 @@
+#include <Geode/Geode.hpp>
+#include "TombstoneLayer.hpp"
+#include <thread>
+
+using namespace geode::prelude;
+
+namespace {
+    // In points whatever the texture quality; the image has no -hd/-uhd variants, so its content
+    // size shrinks with the content scale factor
+    constexpr float kHeight = 24.0f;
+    constexpr GLubyte kDeathOpacity = 120;
+}
+
+TombstoneLayer* TombstoneLayer::create(PlayLayer* playLayer) {
+    auto ret = new TombstoneLayer();
+    if (ret->init(playLayer)) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool TombstoneLayer::init(PlayLayer* playLayer) {
+    if (!CCNode::init()) return false;
+
+    m_playLayer = playLayer;
+    m_path = Mod::get()->getSaveDir() / "tombstones" / fmt::format("{}.bin", playLayer->m_level->m_levelID.value());
+    m_batch = CCSpriteBatchNode::create("tombstone.png"_spr, 32);
+    this->addChild(m_batch);
+    m_scale = kHeight / m_batch->getTexture()->getContentSize().height;
+
+    // Only what is on disk now; anything recorded from here on goes into the index directly
+    std::error_code error;
+    size_t size = std::filesystem::file_size(m_path, error);
+    if (error || size == 0) {
+        m_loaded = true;
+    } else {
+        m_loading = std::make_shared<Loading>();
+        std::thread([loading = m_loading, path = m_path, size]() {
+            loading->index = TombstoneIndex::load(path, size);
+            loading->done = true;
+        }).detach();
+    }
+
+    this->setID("tombstones"_spr);
+    playLayer->m_objectLayer->addChild(this);
+    this->scheduleUpdate();
+    return true;
+}
+
+void TombstoneLayer::record(CCPoint position, bool newBest, int percent) {
+    Tombstone tombstone = {
+        position.x, position.y,
+        static_cast<uint8_t>(newBest ? Tombstone::NewBest : 0),
+        static_cast<uint8_t>(std::clamp(percent, 0, 100)),
+        0
+    };
+    if (!TombstoneIndex::append(m_path, tombstone)) {
+        log::warn("Could not save tombstone to {}", m_path.string());
+    }
+
+    if (m_loaded) {
+        m_index.insert(tombstone);
+        m_dirty = true;
+    } else {
+        m_recorded.push_back(tombstone);
+    }
+}
+
+void TombstoneLayer::update(float dt) {
+    if (!m_loaded) {
+        if (!m_loading->done) return;
+        m_index = std::move(m_loading->index);
+        m_loading.reset();
+        for (auto const& tombstone : m_recorded) {
+            m_index.insert(tombstone);
+        }
+        m_recorded.clear();
+        m_loaded = true;
+        log::info("Loaded {} tombstones", m_index.size());
+    }
+
+    // The camera window in level coordinates, whatever the camera's zoom and rotation
+    auto winSize = CCDirector::get()->getWinSize();
+    CCPoint corners[] = {
+        this->convertToNodeSpace(ccp(0.0f, 0.0f)),
+        this->convertToNodeSpace(ccp(winSize.width, 0.0f)),
+        this->convertToNodeSpace(ccp(0.0f, winSize.height)),
+        this->convertToNodeSpace(ccp(winSize.width, winSize.height))
+    };
+    float left = corners[0].x, right = corners[0].x, bottom = corners[0].y, top = corners[0].y;
+    for (auto const& corner : corners) {
+        left = std::min(left, corner.x);
+        right = std::max(right, corner.x);
+        bottom = std::min(bottom, corner.y);
+        top = std::max(top, corner.y);
+    }
+    CCRect window(left, bottom, right - left, top - bottom);
+    if (!m_dirty && window.equals(m_window)) return;
+
+    m_window = window;
+    m_dirty = false;
+    refresh();
+}
+
+void TombstoneLayer::refresh() {
+    // Padded by a sprite, so tombstones slide in at the edges instead of popping in
+    auto size = m_batch->getTexture()->getContentSize() * m_scale;
+    float margin = std::max(size.width, size.height);
+    size_t shown = 0;
+    m_index.query(m_window.getMinX() - margin, m_window.getMaxX() + margin,
+        m_window.getMinY() - margin, m_window.getMaxY() + margin, kMaxVisible,
+        [&](Tombstone const& tombstone) {
+            if (shown == m_sprites.size()) {
+                auto sprite = CCSprite::createWithTexture(m_batch->getTexture());
+                sprite->setScale(m_scale);
+                m_batch->addChild(sprite);
+                m_sprites.push_back(sprite);
+            }
+            auto sprite = m_sprites[shown++];
+            sprite->setPosition(ccp(tombstone.x, tombstone.y));
+            sprite->setOpacity(tombstone.flags & Tombstone::NewBest ? 255 : kDeathOpacity);
+            sprite->setVisible(true);
+        }
+    );
+
+    for (size_t i = shown; i < m_shown; i++) {
+        m_sprites[i]->setVisible(false);
+    }
+    m_shown = shown;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <Geode/Geode.hpp>
+#include <atomic>
+#include "TombstoneIndex.hpp"
+
+using namespace geode::prelude;
+
+// Draws the recorded deaths of the current level where they happened, inside the object layer so
+// they scroll with the level. The file is read and sorted on a worker thread, so a level with tens
+// of thousands of deaths loads as fast as one without. Each frame only the tombstones inside the
+// camera window get a sprite, all from one batch node.
+class TombstoneLayer : public CCNode {
+public:
+    // Tombstones with more on screen at once pile up on one spot anyway
+    static constexpr size_t kMaxVisible = 256;
+
+    static TombstoneLayer* create(PlayLayer* playLayer);
+
+    void record(CCPoint position, bool newBest, int percent);
+    void update(float dt) override;
+
+private:
+    struct Loading {
+        TombstoneIndex index;
+        std::atomic<bool> done = false;
+    };
+
+    bool init(PlayLayer* playLayer);
+    void refresh();
+
+    PlayLayer* m_playLayer = nullptr;
+    std::filesystem::path m_path;
+    std::shared_ptr<Loading> m_loading;     // shared with the loader, which may outlive us
+    std::vector<Tombstone> m_recorded;      // deaths recorded before the loader finished
+    TombstoneIndex m_index;
+    bool m_loaded = false;
+
+    CCSpriteBatchNode* m_batch = nullptr;
+    float m_scale = 1.0f;
+    std::vector<CCSprite*> m_sprites;
+    size_t m_shown = 0;
+    CCRect m_window;
+    bool m_dirty = true;
+};
@@ -0,0 +1,118 @@
+#include "Trace.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Spans on one Chrome thread have to nest, the ones outliving the frame they start in get their own
+    constexpr const char* kTracks[] = { "main", "animation", "new-best delay" };
+
+    // Argument names of an event's instant or begin record, then of its end record; null ones are left out
+    struct EventInfo {
+        const char* name;
+        int track;
+        const char* args[3];
+        const char* endArgs[3];
+    };
+
+    constexpr EventInfo kEvents[] = {
+        { "death", 0, { "x", "y", "percent" }, {} },
+        { "new best", 0, { nullptr, nullptr, "percent" }, { nullptr, nullptr, "new nodes" } },
+        { "prepare", 0, { nullptr, nullptr, "players" }, { nullptr, nullptr, "fragments" } },
+        { "prebuilt", 0, {}, {} },
+        { "spawn", 0, { "x", "y", nullptr }, { nullptr, nullptr, "live" } },
+        { "animation", 1, { nullptr, nullptr, "fragments" }, { nullptr, nullptr, "culled draws" } },
+        { "quality lowered", 1, { "average ms", nullptr, "tier" }, {} },
+        { "delay", 2, { "seconds", nullptr, nullptr }, {} },
+        { "respawn blocked", 0, {}, {} },
+        { "skip", 0, { "seconds left", nullptr, nullptr }, {} },
+        { "clear", 0, { nullptr, nullptr, "runners" }, {} },
+    };
+    static_assert(std::size(kEvents) == static_cast<size_t>(TraceEvent::Count));
+
+    const Clock::time_point s_epoch = Clock::now();
+    std::array<Trace::Record, Trace::kCapacity> s_records;
+    uint64_t s_head = 0;
+
+    void writeJson(std::vector<Trace::Record> const& records, std::filesystem::path const& path) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file) return;
+
+        char line[256];
+        file << "{\"traceEvents\":[";
+        for (size_t track = 0; track < std::size(kTracks); track++) {
+            std::snprintf(line, sizeof(line), R"({"name":"thread_name","ph":"M","pid":1,"tid":%d,"args":{"name":"%s"}})",
+                static_cast<int>(track) + 1, kTracks[track]
+            );
+            file << (track ? ",\n" : "\n") << line;
+        }
+        for (auto const& record : records) {
+            auto const& info = kEvents[static_cast<size_t>(record.event)];
+            auto const& names = record.phase == 'E' ? info.endArgs : info.args;
+            std::snprintf(line, sizeof(line), R"({"name":"%s","cat":"death","ph":"%c","pid":1,"tid":%d,"ts":%.3f)",
+                info.name, record.phase, info.track + 1, static_cast<double>(record.time) / 1000.0
+            );
+            file << ",\n" << line;
+            if (record.phase == 'i') {
+                file << R"(,"s":"t")";
+            }
+
+            file << ",\"args\":{";
+            bool first = true;
+            auto arg = [&](const char* name, double value, const char* format) {
+                if (!name) return;
+                std::snprintf(line, sizeof(line), format, value);
+                file << (first ? "" : ",") << '"' << name << "\":" << line;
+                first = false;
+            };
+            arg(names[0], record.x, "%.2f");
+            arg(names[1], record.y, "%.2f");
+            arg(names[2], record.value, "%.0f");
+            file << "}}";
+        }
+        file << "\n]}\n";
+    }
+}
+
+void Trace::record(TraceEvent event, char phase, float x, float y, int32_t value) {
+    uint64_t index = s_head;
+    auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - s_epoch).count();
+    s_records[index % kCapacity] = { static_cast<uint64_t>(time), event, phase, 0, value, x, y };
+    s_head = index + 1;
+}
+
+void Trace::instant(TraceEvent event, float x, float y, int32_t value) {
+    record(event, 'i', x, y, value);
+}
+
+void Trace::begin(TraceEvent event, float x, float y, int32_t value) {
+    record(event, 'B', x, y, value);
+}
+
+void Trace::end(TraceEvent event, float x, float y, int32_t value) {
+    record(event, 'E', x, y, value);
+}
+
+size_t Trace::exportJson(std::filesystem::path const& path) {
+    // On the main thread, like every record, so the ring can't move while it is copied; only
+    // the writing is left to a worker
+    uint64_t head = s_head;
+    uint64_t first = head > kCapacity ? head - kCapacity : 0;
+    std::vector<Record> records;
+    records.reserve(static_cast<size_t>(head - first));
+    for (uint64_t index = first; index < head; index++) {
+        records.push_back(s_records[index % kCapacity]);
+    }
+
+    size_t count = records.size();
+    std::thread([records = std::move(records), path]() {
+        writeJson(records, path);
+    }).detach();
+    return count;
+}
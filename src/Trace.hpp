@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// What happens on the death path, in order. Each event is one record with up to three numbers,
+// named per event when the trace is written out.
+enum class TraceEvent : uint8_t {
+    Death,          // instant: x, y, percent
+    NewBest,        // span: the new-best frame; percent, then new fragment nodes allocated
+    Prepare,        // span: building an animation's timeline; players, then fragments
+    Prebuilt,       // instant: the timeline built ahead of time was used
+    Spawn,          // span: starting the runner at its first origin; fragments live on the first frame
+    Animation,      // span: from the first frame to finishing or being cancelled; fragment draws culled
+    QualityLowered, // instant: average frame milliseconds, the new tier
+    Delay,          // span: the new-best delay; seconds
+    RespawnBlocked, // instant
+    Skip,           // span: from the skip press to the first frame of the next attempt; seconds of delay left
+    Clear,          // instant: running animations cancelled by a reset or exit
+    Count
+};
+
+// Tracing for the death path, cheap enough to leave on: recording an event is a clock read and one
+// 24-byte store into a fixed ring, with no formatting, locking or allocation. Events are recorded
+// and exported on the main thread only, so the ring needs no synchronisation. Nothing is formatted
+// until the trace is exported, which copies the ring and writes Chrome trace JSON
+// (chrome://tracing, Perfetto) from a worker thread.
+class Trace {
+public:
+    static constexpr size_t kCapacity = 4096;
+
+    struct Record {
+        uint64_t time;      // nanoseconds since the first event
+        TraceEvent event;
+        char phase;         // Chrome's: 'i' instant, 'B' begin, 'E' end
+        uint16_t reserved;
+        int32_t value;
+        float x;
+        float y;
+    };
+    static_assert(sizeof(Record) == 24);
+
+    static void instant(TraceEvent event, float x = 0.0f, float y = 0.0f, int32_t value = 0);
+    static void begin(TraceEvent event, float x = 0.0f, float y = 0.0f, int32_t value = 0);
+    static void end(TraceEvent event, float x = 0.0f, float y = 0.0f, int32_t value = 0);
+
+    // Main thread only: copies what is still in the ring and writes it in the background;
+    // returns how many events
+    static size_t exportJson(std::filesystem::path const& path);
+
+private:
+    static void record(TraceEvent event, char phase, float x, float y, int32_t value);
+};
@@ -1,17 +1,38 @@
 #include <Geode/Geode.hpp>
-#include <Geode/loader/Event.hpp>
+#include "Config.hpp"
 #include "DeathAnimations.hpp"
+#include "GhostNode.hpp"
+#include "HeatmapLayer.hpp"
+#include "PerformanceOverlay.hpp"
+#include "TombstoneLayer.hpp"
+#include "Trace.hpp"
 
 using namespace geode::prelude;
 
+// How close to the best, in percent, the animation is built ahead of the death
+constexpr float kPrebuildMargin = 5.0f;
+
 #include <Geode/modify/PlayLayer.hpp>
+#include <Geode/modify/GJBaseGameLayer.hpp>
 #include <Geode/modify/MenuLayer.hpp>
 
+$on_mod(Loaded) {
+    DeathAnimations::loadDefinitions();
+    Config::load();
+    
+    if (Config::get().benchmarkOnLoad) {
+        DeathAnimations::runBenchmark(100);
+    }
+}
+
 class $modify(MyPlayLayer, PlayLayer) {
     struct Fields {
         bool m_delayActive = false;
         bool m_showingDelayedBest = false;
-        EventListener<Task<bool, int>> m_delayTaskListener;
+        float m_delayRemaining = 0.0f;
+        bool m_resetBlocked = false;        // the game's own respawn came during the delay and was held back
+        int m_skipResetAttempt = -1;        // a skip respawned into this attempt before the game's own respawn came, which is now stale
+        bool m_skipped = false;
         bool m_newReward;
         int m_orbs;
         int m_diamonds;
@@ -19,20 +40,123 @@ class $modify(MyPlayLayer, PlayLayer) {
         bool m_noRetry;
         bool m_noTitle;
         CCPoint m_deathPosition;
+        std::array<std::optional<CCPoint>, 2> m_playerDeaths;   // each player's own, for dual mode
+        int m_deathPercent = 0;
+        bool m_died = false;
+        bool m_diedWithNewBest = false;
+        Ref<AnimationLayer> m_animationLayer;
+        std::optional<DeathAnimations::Prepared> m_prepared;
+        int m_preparedAttempt = -1;
+        Ref<TombstoneLayer> m_tombstones;
+        Ref<HeatmapLayer> m_heatmap;
+        bool m_recordGhost = false;
+        GhostRecorder m_ghost;
     };
     
+    bool init(GJGameLevel* level, bool useReplay, bool dontCreateObjects) {
+        if (!PlayLayer::init(level, useReplay, dontCreateObjects)) return false;
+        
+        // Every animation node lives under this one layer, so resets and exits clear them at once
+        m_fields->m_animationLayer = AnimationLayer::create(this);
+        
+        // Everything the selected animation needs is allocated now, so new bests never allocate
+        DeathAnimations::prewarm(m_fields->m_animationLayer);
+        
+        auto const& config = Config::get();
+        m_fields->m_recordGhost = config.ghostReplay;
+        
+        // Local levels have no ID to keep their tombstones and heatmap under
+        if (m_level->m_levelID.value() != 0) {
+            if (config.heatmap != HeatmapMode::Off) {
+                m_fields->m_heatmap = HeatmapLayer::create(this, config.heatmap == HeatmapMode::Paused);
+            }
+            if (config.tombstones != TombstoneMode::Off) {
+                m_fields->m_tombstones = TombstoneLayer::create(this);
+            }
+        }
+        
+        return true;
+    }
+    
+    // A death is only recorded once the attempt is over, when it is known whether it was a new best
+    void recordDeath() {
+        bool died = m_fields->m_died;
+        bool newBest = m_fields->m_diedWithNewBest;
+        m_fields->m_died = false;
+        m_fields->m_diedWithNewBest = false;
+        
+        if (!died || !m_fields->m_tombstones) return;
+        if (newBest || Config::get().tombstones == TombstoneMode::AllDeaths) {
+            m_fields->m_tombstones->record(m_fields->m_deathPosition, newBest, m_fields->m_deathPercent);
+        }
+    }
+    
+    void postUpdate(float dt) {
+        PlayLayer::postUpdate(dt);
+        
+        if (m_fields->m_skipped) {
+            m_fields->m_skipped = false;
+            Trace::end(TraceEvent::Skip);
+        }
+        DeathAnimations::updateFlipbook();
+        
+        if (m_fields->m_recordGhost && !m_isPracticeMode && !m_player1->m_isDead) {
+            m_fields->m_ghost.record(dt,
+                m_player1->getPositionX(), m_player1->getPositionY(), m_player1->getRotation(),
+                GhostNode::modeOf(m_player1), m_player1->m_isUpsideDown
+            );
+        }
+        
+        // One build per attempt, made when the run gets close enough to the best that the death
+        // may be a new one, so showNewBest only has to start it
+        if (m_isPracticeMode || m_isPlatformer || m_fields->m_delayActive) return;
+        if (m_fields->m_preparedAttempt == m_attempts || !m_fields->m_animationLayer) return;
+        if (this->getCurrentPercent() < m_level->m_normalPercent.value() - kPrebuildMargin) return;
+        
+        m_fields->m_preparedAttempt = m_attempts;
+        m_fields->m_prepared = DeathAnimations::prepareSelectedAnimation(this, m_fields->m_animationLayer);
+    }
+    
+    // In dual mode both players animate, each from where it died, or stopped if it didn't
+    std::vector<CCPoint> deathOrigins() {
+        if (!m_gameState.m_isDualMode || !m_player1 || !m_player2) {
+            return { m_fields->m_deathPosition };
+        }
+        return {
+            m_fields->m_playerDeaths[0].value_or(m_player1->getPosition()),
+            m_fields->m_playerDeaths[1].value_or(m_player2->getPosition())
+        };
+    }
+    
     void showNewBest(bool newReward, int orbs, int diamonds, bool demonKey, bool noRetry, bool noTitle) {
         if (m_fields->m_showingDelayedBest) {
             PlayLayer::showNewBest(newReward, orbs, diamonds, demonKey, noRetry, noTitle);
             return;
         }
         
-        log::info("NEW BEST ACHIEVED! Starting death animation...");
+        Trace::begin(TraceEvent::NewBest, 0.0f, 0.0f, m_fields->m_deathPercent);
+        m_fields->m_diedWithNewBest = true;
+        
+        auto layer = m_fields->m_animationLayer.data();
+        size_t allocationsBefore = layer->getPool().getAllocationCount();
+        auto spawnStart = std::chrono::steady_clock::now();
+        auto runner = DeathAnimations::createSelectedAnimation(this, deathOrigins(), layer, std::move(m_fields->m_prepared));
+        m_fields->m_prepared.reset();
+        float spawnMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - spawnStart).count();
         
-        std::string animationType = Mod::get()->getSettingValue<std::string>("animation-type");
-        log::info("Selected animation type: {}", animationType);
+        if (runner && Config::get().performanceOverlay) {
+            layer->addChild(PerformanceOverlay::create(runner, spawnMilliseconds), 3000);
+        }
         
-        DeathAnimations::createSelectedAnimation(this, m_fields->m_deathPosition);
+        // The ghost covers as much of the run as the delay lasts, reaching the death as it ends.
+        // Grinding leaves too little time for it to show anything
+        auto const& config = Config::get();
+        float delay = config.getDelay();
+        if (m_fields->m_recordGhost && !config.grind && m_fields->m_ghost.size() > 1) {
+            if (auto ghost = GhostNode::create(this, GhostTrack(m_fields->m_ghost.extract(delay)), delay)) {
+                layer->addChild(ghost);
+            }
+        }
         
         m_fields->m_newReward = newReward;
         m_fields->m_orbs = orbs;
@@ -43,53 +167,79 @@ class $modify(MyPlayLayer, PlayLayer) {
         
         m_fields->m_delayActive = true;
         
-        int delaySeconds = Mod::get()->getSettingValue<int64_t>("delay-duration");
-        int delayMs = delaySeconds * 1000;
-        
-        auto delayTask = Task<bool, int>::run([delayMs](auto progress, auto hasBeenCancelled) -> Task<bool, int>::Result {
-            const int checkInterval = 100;
-            int elapsed = 0;
-            
-            while (elapsed < delayMs) {
-                if (hasBeenCancelled()) {
-                    return Task<bool, int>::Cancel();
-                }
-                
-                progress(static_cast<int>((float)elapsed / delayMs * 100));
-                
-                std::this_thread::sleep_for(std::chrono::milliseconds(checkInterval));
-                elapsed += checkInterval;
-            }
-            
-            return true;
-        }, "New Best Delay Task");
-        
-        m_fields->m_delayTaskListener.bind([this](Task<bool, int>::Event* event) {
-            if (event->getValue()) {
-                m_fields->m_delayActive = false;
-                m_fields->m_showingDelayedBest = true;
-                
-                this->showNewBest(
-                    m_fields->m_newReward,
-                    m_fields->m_orbs, 
-                    m_fields->m_diamonds,
-                    m_fields->m_demonKey,
-                    m_fields->m_noRetry,
-                    m_fields->m_noTitle
-                );
-                
-                m_fields->m_showingDelayedBest = false;
-            }
-            return ListenerResult::Propagate;
-        });
+        // Counted down on the PlayLayer's own scheduler, so it follows the game's frames and pauses
+        m_fields->m_delayRemaining = delay;
+        this->schedule(schedule_selector(MyPlayLayer::updateNewBestDelay));
+        Trace::begin(TraceEvent::Delay, delay);
+        Trace::end(TraceEvent::NewBest, 0.0f, 0.0f, static_cast<int32_t>(layer->getPool().getAllocationCount() - allocationsBefore));
+    }
+    
+    void updateNewBestDelay(float dt) {
+        if (!m_fields->m_delayActive || m_isPaused) return;
         
-        m_fields->m_delayTaskListener.setFilter(delayTask);
+        m_fields->m_delayRemaining -= dt;
+        if (m_fields->m_delayRemaining > 0.0f) return;
+        
+        finishNewBestDelay();
+    }
+    
+    // Shows the held-back new best, whether the delay ran out or was skipped, paused or not
+    void finishNewBestDelay() {
+        this->unschedule(schedule_selector(MyPlayLayer::updateNewBestDelay));
+        m_fields->m_delayActive = false;
+        m_fields->m_showingDelayedBest = true;
+        Trace::end(TraceEvent::Delay);
+        
+        this->showNewBest(
+            m_fields->m_newReward,
+            m_fields->m_orbs, 
+            m_fields->m_diamonds,
+            m_fields->m_demonKey,
+            m_fields->m_noRetry,
+            m_fields->m_noTitle
+        );
+        
+        m_fields->m_showingDelayedBest = false;
+    }
+    
+    // Ends the new-best delay on the spot: the animation is dropped, the new best shown and the
+    // level reset in the same frame, so the next one is already playable
+    bool skipNewBestDelay() {
+        if (!m_fields->m_delayActive) return false;
+        
+        Trace::begin(TraceEvent::Skip, m_fields->m_delayRemaining);
+        m_fields->m_delayRemaining = 0.0f;
+        m_fields->m_skipped = true;
+        if (m_fields->m_animationLayer) {
+            m_fields->m_animationLayer->clear();
+        }
+        finishNewBestDelay();
+        
+        // Still to come if it wasn't held back yet, and by then this reset has already happened.
+        // It belongs to the attempt the reset starts, so a quick death there doesn't clear it
+        bool respawnStale = !m_fields->m_resetBlocked;
+        PlayLayer::delayedResetLevel();
+        m_fields->m_skipResetAttempt = respawnStale ? m_attempts : -1;
+        return true;
     }
     
     void resetLevel() {
+        m_fields->m_resetBlocked = false;
         if (m_fields->m_delayActive) {
             m_fields->m_delayActive = false;
+            this->unschedule(schedule_selector(MyPlayLayer::updateNewBestDelay));
+            Trace::end(TraceEvent::Delay);
+        }
+        
+        // Stop the animations before the players are restored, so nothing animates them again.
+        // The base init can reset before ours has created the layer
+        if (m_fields->m_animationLayer) {
+            m_fields->m_animationLayer->clear();
         }
+        m_fields->m_prepared.reset();
+        m_fields->m_ghost.clear();
+        m_fields->m_playerDeaths = {};
+        recordDeath();
         
         auto player1 = this->m_player1;
         auto player2 = this->m_player2;
@@ -115,20 +265,71 @@ class $modify(MyPlayLayer, PlayLayer) {
         PlayLayer::resetLevel();
     }
     
-    void destroyPlayer(PlayerObject* player, GameObject* object) {
-        log::info("Player died at position ({}, {})", player->getPosition().x, player->getPosition().y);
+    void onQuit() {
+        if (m_fields->m_animationLayer) {
+            m_fields->m_animationLayer->clear();
+        }
+        m_fields->m_prepared.reset();
+        DeathAnimations::releaseFlipbook();
+        recordDeath();
+        if (m_fields->m_heatmap) {
+            m_fields->m_heatmap->save();
+        }
+        if (Config::get().traceExport) {
+            auto path = Mod::get()->getSaveDir() / "trace.json";
+            log::info("Writing {} trace events to {}", Trace::exportJson(path), path.string());
+        }
         
+        PlayLayer::onQuit();
+    }
+    
+    void destroyPlayer(PlayerObject* player, GameObject* object) {
         m_fields->m_deathPosition = player->getPosition();
+        m_fields->m_deathPercent = static_cast<int>(this->getCurrentPercent());
+        Trace::instant(TraceEvent::Death, m_fields->m_deathPosition.x, m_fields->m_deathPosition.y, m_fields->m_deathPercent);
+        auto& playerDeath = m_fields->m_playerDeaths[player == m_player2 ? 1 : 0];
+        playerDeath = player->getPosition();
         
         PlayLayer::destroyPlayer(player, object);
+        
+        // Not every call kills, the level start calls it with the anti-cheat spike
+        if (!player->m_isDead) {
+            playerDeath.reset();
+            return;
+        }
+        if (m_isPracticeMode) return;
+        m_fields->m_died = true;
+        if (m_fields->m_heatmap) {
+            m_fields->m_heatmap->record(m_fields->m_deathPosition);
+        }
     }
     
     void delayedResetLevel() {
         if (m_fields->m_delayActive) {
-            log::info("Blocked auto-respawn because new best delay is active");
+            m_fields->m_resetBlocked = true;
+            Trace::instant(TraceEvent::RespawnBlocked);
+            return;
+        }
+        // Scheduled before any death in the attempt the skip started, so it is always the first to come
+        if (m_fields->m_skipResetAttempt == m_attempts) {
+            m_fields->m_skipResetAttempt = -1;
             return;
         }
         
         PlayLayer::delayedResetLevel();
     }
+};
+
+// Clicks, space and the jump keybinds all arrive as the jump button, the other buttons are
+// platformer left and right. A press that skips the delay is not passed on to the new attempt.
+class $modify(SkipGameLayer, GJBaseGameLayer) {
+    void handleButton(bool down, int button, bool isPlayer1) {
+        auto skip = Config::get().skipInput;
+        auto playLayer = PlayLayer::get();
+        if (down && playLayer && playLayer == static_cast<GJBaseGameLayer*>(this) && (skip == SkipInput::AnyButton || (skip == SkipInput::Jump && button == 1))) {
+            if (static_cast<MyPlayLayer*>(playLayer)->skipNewBestDelay()) return;
+        }
+        
+        GJBaseGameLayer::handleButton(down, button, isPlayer1);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include <Geode/Geode.hpp>
+#include "AnimationBenchmark.hpp"
+#include "AnimationCompiler.hpp"
+#include "AnimationPack.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The in-game benchmark without the game. The animation definitions in resources/animations are
+// compiled the way the mod compiles them and measured one by one, as is every compiled pack passed
+// in (the mod writes one to animations.bin in its save folder). Frames drive a stub scene graph,
+// so node setters and quad building are timed with the timeline, and every heap allocation is
+// counted, which should find none once the first frame runs.
+
+namespace {
+    struct Allocations {
+        size_t count = 0;
+        size_t liveBytes = 0;
+        size_t peakBytes = 0;
+    };
+    Allocations s_allocations;
+
+    // Each block keeps its size in front of it, so frees can be counted off the live total
+    constexpr size_t kHeader = alignof(std::max_align_t);
+
+    void* allocate(size_t size) {
+        auto block = static_cast<unsigned char*>(std::malloc(size + kHeader));
+        if (!block) throw std::bad_alloc();
+        std::memcpy(block, &size, sizeof(size));
+        s_allocations.count++;
+        s_allocations.liveBytes += size;
+        s_allocations.peakBytes = std::max(s_allocations.peakBytes, s_allocations.liveBytes);
+        return block + kHeader;
+    }
+
+    void deallocate(void* pointer) {
+        if (!pointer) return;
+        auto block = static_cast<unsigned char*>(pointer) - kHeader;
+        size_t size;
+        std::memcpy(&size, block, sizeof(size));
+        s_allocations.liveBytes -= size;
+        std::free(block);
+    }
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* pointer) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { deallocate(pointer); }
+
+namespace {
+    // What the mod measures with: a 16:9 screen and a player, so nothing is skipped
+    AnimationPack::Context benchmarkContext() {
+        AnimationPack::Context context;
+        context.winWidth = 569.0f;
+        context.winHeight = 320.0f;
+        context.fragmentHeight = 40.0f;
+        return context;
+    }
+
+    // The nodes AnimationRunner drives: a sprite per fragment in a batch per layer, set the way
+    // AnimationRunner::apply sets them, and a quad per live particle the way BurstNode builds them
+    class StubScene : public AnimationBenchmark::Scene {
+    public:
+        void load(Timeline const& timeline) override {
+            if (m_root) m_root->release();
+            m_root = new CCNode();
+            m_timeline = &timeline;
+            m_sprites.clear();
+            std::vector<CCNode*> batches;
+            for (int zOrder : timeline.getLayers()) {
+                auto batch = CCNode::create();
+                m_root->addChild(batch, zOrder);
+                batches.push_back(batch);
+            }
+            for (auto const& fragment : timeline.getFragments()) {
+                auto sprite = new CCSprite();
+                sprite->autorelease();
+                sprite->setContentSize({ 40.0f, 40.0f });
+                sprite->setScaleX(fragment.scaleX);
+                sprite->setScaleY(fragment.scaleY);
+                sprite->setVisible(false);
+                batches[std::min<size_t>(fragment.layer, batches.size() - 1)]->addChild(sprite, fragment.zOrder);
+                m_sprites.push_back(sprite);
+            }
+            m_quads.assign(timeline.getBursts().size(), {});
+            for (size_t burst = 0; burst < m_quads.size(); burst++) {
+                m_quads[burst].resize(timeline.getBursts()[burst].size() * 4);
+            }
+            m_quadCounts.assign(m_quads.size(), 0);
+            CCPoolManager::sharedPoolManager()->pop();
+            m_counted = s_allocations.count;
+        }
+
+        void apply(size_t fragment, float const* values) override {
+            auto const& desc = m_timeline->getFragments()[fragment];
+            auto sprite = m_sprites[fragment];
+            sprite->setVisible(true);
+            if (desc.target != Timeline::Target::Overlay) {
+                if (isAnimated(desc, Timeline::X) || isAnimated(desc, Timeline::Y)) {
+                    sprite->setPosition(ccp(values[Timeline::X], values[Timeline::Y]));
+                }
+                if (isAnimated(desc, Timeline::Scale)) {
+                    sprite->setScaleX(values[Timeline::Scale] * desc.scaleX);
+                    sprite->setScaleY(values[Timeline::Scale] * desc.scaleY);
+                }
+                if (isAnimated(desc, Timeline::Rotation)) {
+                    sprite->setRotation(values[Timeline::Rotation]);
+                }
+            }
+            if (isAnimated(desc, Timeline::Red) || isAnimated(desc, Timeline::Green) || isAnimated(desc, Timeline::Blue)) {
+                sprite->setColor(ccc3(toByte(values[Timeline::Red]), toByte(values[Timeline::Green]), toByte(values[Timeline::Blue])));
+            }
+            if (isAnimated(desc, Timeline::Opacity)) {
+                sprite->setOpacity(toByte(values[Timeline::Opacity]));
+            }
+        }
+
+        void retire(size_t fragment) override {
+            m_sprites[fragment]->setVisible(false);
+        }
+
+        void advance(size_t burst, ParticleBurst const& particles) override {
+            auto x = particles.getX();
+            auto y = particles.getY();
+            auto rotation = particles.getRotation();
+            auto scale = particles.getScale();
+            auto alpha = particles.getAlpha();
+            auto& quads = m_quads[burst];
+            size_t count = 0;
+            for (size_t i = 0; i < particles.size(); i++) {
+                if (scale[i] <= 0.0f || alpha[i] < 0.5f) continue;
+                float radians = CC_DEGREES_TO_RADIANS(rotation[i]);
+                float cos = std::cos(radians) * scale[i] * 4.0f;
+                float sin = std::sin(radians) * scale[i] * 4.0f;
+                quads[count * 4 + 0] = ccp(x[i] - cos - sin, y[i] + sin - cos);
+                quads[count * 4 + 1] = ccp(x[i] + cos - sin, y[i] - sin - cos);
+                quads[count * 4 + 2] = ccp(x[i] - cos + sin, y[i] + sin + cos);
+                quads[count * 4 + 3] = ccp(x[i] + cos + sin, y[i] - sin + cos);
+                count++;
+            }
+            m_quadCounts[burst] = count;
+        }
+
+        size_t draw() override {
+            size_t drawn = m_root->visit();
+            for (size_t count : m_quadCounts) {
+                drawn += count;
+            }
+            m_frameAllocations += s_allocations.count - m_counted;
+            m_counted = s_allocations.count;
+            return drawn;
+        }
+
+        // Made between a run's first frame and its last draw, over every run so far
+        size_t getFrameAllocations() const { return m_frameAllocations; }
+
+        ~StubScene() override {
+            if (m_root) m_root->release();
+        }
+
+    private:
+        static bool isAnimated(Timeline::Fragment const& desc, Timeline::Channel channel) {
+            return desc.animated & (1 << channel);
+        }
+        static GLubyte toByte(float value) {
+            return static_cast<GLubyte>(std::clamp(value, 0.0f, 255.0f));
+        }
+
+        CCNode* m_root = nullptr;
+        Timeline const* m_timeline = nullptr;
+        std::vector<CCSprite*> m_sprites;
+        std::vector<std::vector<CCPoint>> m_quads;
+        std::vector<size_t> m_quadCounts;
+        size_t m_counted = 0;
+        size_t m_frameAllocations = 0;
+    };
+
+    // Returns false if any frame allocated, which the pool and runner are built never to do
+    bool report(const char* name, std::function<Timeline()> const& build, int iterations) {
+        // One build on its own for its allocations and the most heap it held at once
+        size_t countBefore = s_allocations.count;
+        size_t liveBefore = s_allocations.liveBytes;
+        s_allocations.peakBytes = liveBefore;
+        {
+            auto timeline = build();
+        }
+        size_t buildAllocations = s_allocations.count - countBefore;
+        size_t buildPeak = s_allocations.peakBytes - liveBefore;
+
+        StubScene scene;
+        auto result = AnimationBenchmark::run(build, iterations, &scene);
+
+        std::printf("%s: built in %.1fus with %zu allocations (%zu KiB at peak), %zu fragments, %zu particles, %zu nodes (%zu live at peak), %zu keys, %zu KiB, %.2fs\n",
+            name, result.buildMicroseconds, buildAllocations, buildPeak / 1024, result.fragments, result.particles, result.nodes,
+            result.peakLiveNodes, result.keys, result.memoryBytes / 1024, result.duration
+        );
+        for (auto const& frames : result.frames) {
+            std::printf("%s @ %d Hz: %zu frames, %.2fus average, %.2fus worst (%.2f%% of the frame budget), %zu quads at most\n",
+                name, frames.refreshRate, frames.frames, frames.averageMicroseconds, frames.worstMicroseconds, frames.budgetPercent, frames.peakDrawn
+            );
+        }
+        std::printf("%s: %zu allocations during frames\n", name, scene.getFrameAllocations());
+
+        // Timeline evaluation only, live and next to the small flipbook; node updates and draws are not in either
+        auto flipbook = AnimationBenchmark::compareFlipbook(build(), Flipbook::Stamp::square(32, 40.0f), { 192, 24.0f });
+        std::printf("%s flipbook: baked in %.1fms, %u frames of %ux%u, %zu KiB texture, %zu KiB on disk, %.2fus evaluated live, %.2fus next to the flipbook (%zu fragments left live)\n",
+            name, flipbook.bakeMilliseconds, flipbook.frames, flipbook.frameWidth, flipbook.frameHeight,
+            flipbook.textureBytes / 1024, flipbook.diskBytes / 1024, flipbook.liveMicroseconds, flipbook.flipbookMicroseconds, flipbook.liveFragments
+        );
+        return scene.getFrameAllocations() == 0;
+    }
+
+    bool benchmarkPack(AnimationPack const& pack, int iterations) {
+        bool ok = true;
+        auto context = benchmarkContext();
+        for (size_t i = 0; i < pack.getAnimationCount(); i++) {
+            auto animation = pack.getAnimation(i);
+            ok &= report(animation->name, [&]() {
+                Random random(Random::seedFor(0, 1));
+                TimelineBuilder timeline;
+                pack.expand(*animation, context, random, timeline);
+                return timeline.build();
+            }, iterations);
+        }
+        return ok;
+    }
+
+    bool benchmarkFile(const char* path, int iterations) {
+        MappedFile file;
+        AnimationPack pack;
+        if (!file.open(path) || !pack.attach(file.data(), file.size())) {
+            std::fprintf(stderr, "%s is not a compiled animation pack\n", path);
+            return false;
+        }
+        return benchmarkPack(pack, iterations);
+    }
+
+    // Compiled like DeathAnimations::loadDefinitions does, in file name order
+    bool benchmarkDefinitions(std::filesystem::path const& directory, int iterations) {
+        std::vector<std::filesystem::path> paths;
+        std::error_code error;
+        for (auto const& entry : std::filesystem::directory_iterator(directory, error)) {
+            if (entry.path().extension() == ".json") {
+                paths.push_back(entry.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        if (paths.empty()) {
+            std::fprintf(stderr, "No animation definitions in %s\n", directory.string().c_str());
+            return false;
+        }
+
+        bool ok = true;
+        AnimationCompiler compiler;
+        for (auto const& path : paths) {
+            std::ifstream file(path, std::ios::binary);
+            std::stringstream json;
+            json << file.rdbuf();
+            auto result = compiler.add(path.stem().string(), json.str());
+            if (!result) {
+                std::fprintf(stderr, "Skipping animation %s: %s\n", path.filename().string().c_str(), result.unwrapErr().c_str());
+                ok = false;
+            }
+        }
+
+        auto compiled = compiler.finish(0);
+        AnimationPack pack;
+        if (!pack.attach(compiled.data(), compiled.size())) {
+            std::fprintf(stderr, "The compiled definitions don't validate\n");
+            return false;
+        }
+        return benchmarkPack(pack, iterations) && ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = 100;
+    std::filesystem::path definitions = TOMBSTONE_ANIMATIONS_DIR;
+    std::vector<const char*> packs;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(std::atoi(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--definitions") == 0 && i + 1 < argc) {
+            definitions = argv[++i];
+        } else {
+            packs.push_back(argv[i]);
+        }
+    }
+
+    bool ok = benchmarkDefinitions(definitions, iterations);
+    for (auto path : packs) {
+        ok &= benchmarkFile(path, iterations);
+    }
+
+    for (int rate : AnimationBenchmark::kRefreshRates) {
+        auto ghost = AnimationBenchmark::recordGhost(rate);
+        std::printf("ghost @ %d Hz: %.1fns per frame, %zu KiB per minute, ring of %zu KiB holds %.0fs, last 10s decoded in %.1fus, %.3f units off at worst\n",
+            rate, ghost.recordNanoseconds, ghost.bytesPerMinute / 1024, GhostRecorder::getMemoryUsage() / 1024,
+            ghost.ringSeconds, ghost.extractMicroseconds, ghost.worstError
+        );
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#include "GhostNode.hpp"
+#include <cmath>
+#include <cstdio>
+
+// Creates a ghost and attaches it the way showNewBest does, against the stub scene graph: made
+// with no parent, then added to a layer that is already running. Checks that the first frame is
+// placed on entering, mapped from the object layer through a moved and zoomed camera, and that
+// the ghost follows the recording, holds while paused and removes itself at the end.
+
+namespace {
+    int s_failures = 0;
+
+    void expect(bool condition, const char* what, int line) {
+        if (!condition) {
+            std::fprintf(stderr, "line %d: %s\n", line, what);
+            s_failures++;
+        }
+    }
+
+    bool near(CCPoint a, CCPoint b) {
+        return std::abs(a.x - b.x) < 1e-3f && std::abs(a.y - b.y) < 1e-3f;
+    }
+
+    #define EXPECT(condition) expect(condition, #condition, __LINE__)
+
+    // Two seconds of running right at 60 Hz, a jump halfway
+    std::vector<GhostSample> recording() {
+        std::vector<GhostSample> samples;
+        for (int frame = 0; frame <= 120; frame++) {
+            float time = frame / 60.0f;
+            float jump = std::max(0.0f, 1.0f - std::abs(time - 1.0f) * 4.0f);
+            samples.push_back({ time, time * 300.0f, 105.0f + jump * 60.0f, time * 90.0f, GhostMode::Cube, false });
+        }
+        return samples;
+    }
+
+    // Where the ghost's icon should be at the recording's time, as seen from the layer it is in
+    CCPoint expected(CCNode* layer, CCLayer* objectLayer, float time) {
+        auto sample = GhostTrack(recording()).sample(time);
+        return layer->convertToNodeSpace(objectLayer->convertToWorldSpace(ccp(sample.x, sample.y)));
+    }
+
+    void checkAttach() {
+        auto playLayer = new PlayLayer();
+        playLayer->m_objectLayer = CCLayer::create();
+        playLayer->m_objectLayer->setPosition(ccp(-420.0f, 30.0f));
+        playLayer->m_objectLayer->setScale(0.5f);
+        playLayer->addChild(playLayer->m_objectLayer);
+        auto layer = CCNode::create();
+        layer->setPosition(ccp(12.0f, -8.0f));
+        playLayer->addChild(layer, 1000);
+        playLayer->onEnter();
+
+        // Covering the last second, so it starts at 1s and reaches the end of the recording as it ends
+        auto ghost = GhostNode::create(playLayer, GhostTrack(recording()), 1.0f);
+        EXPECT(ghost != nullptr);
+        if (!ghost) return;
+        EXPECT(ghost->getParent() == nullptr);
+        auto icon = static_cast<SimplePlayer*>(ghost->getChildren().front());
+
+        // Not placed until it has a parent to be placed in
+        ghost->update(0.5f);
+        EXPECT(near(icon->getPosition(), CCPoint()));
+
+        layer->addChild(ghost);
+        EXPECT(ghost->isRunning());
+        EXPECT(ghost->isUpdateScheduled());
+        EXPECT(near(icon->getPosition(), expected(layer, playLayer->m_objectLayer, 1.0f)));
+        EXPECT(std::abs(icon->getScaleX() - 0.5f) < 1e-4f);
+        EXPECT(icon->getOpacity() == 0);
+
+        for (int frame = 0; frame < 30; frame++) {
+            ghost->update(1.0f / 60.0f);
+        }
+        EXPECT(near(icon->getPosition(), expected(layer, playLayer->m_objectLayer, 1.5f)));
+        EXPECT(icon->getOpacity() == GhostNode::kOpacity);
+
+        // Paused, it stays where it is
+        playLayer->m_isPaused = true;
+        auto paused = icon->getPosition();
+        ghost->update(0.25f);
+        EXPECT(near(icon->getPosition(), paused));
+        playLayer->m_isPaused = false;
+
+        ghost->update(0.6f);
+        EXPECT(layer->getChildrenCount() == 0);
+
+        playLayer->onExit();
+        playLayer->release();
+        CCPoolManager::sharedPoolManager()->pop();
+    }
+}
+
+int main() {
+    checkAttach();
+    if (s_failures) {
+        std::fprintf(stderr, "%d ghost checks failed\n", s_failures);
+        return 1;
+    }
+    std::printf("Ghost checks passed\n");
+    return 0;
+}
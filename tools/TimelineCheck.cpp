@@ -0,0 +1,155 @@
+#include "Timeline.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Samples timelines without cocos2d and checks them against what the actions they replace
+// would show: tweens, eases and arcs, scaling to a new duration and dropping fragments.
+
+namespace {
+    int s_failures = 0;
+
+    void expect(bool condition, const char* what, int line) {
+        if (!condition) {
+            std::fprintf(stderr, "line %d: %s\n", line, what);
+            s_failures++;
+        }
+    }
+
+    bool near(float a, float b, float tolerance = 1e-4f) {
+        return std::abs(a - b) <= tolerance * std::max(1.0f, std::abs(b));
+    }
+
+    #define EXPECT(condition) expect(condition, #condition, __LINE__)
+
+    // Fragment 0 slides, 1 is an overlay fading in, 2 jumps and 3 pulses its scale
+    Timeline fourFragments() {
+        TimelineBuilder builder;
+        uint8_t layer = builder.addLayer(10);
+        builder.add(Timeline::Target::Fragment, layer, 0, {})
+            .moveTo(1.0f, 100.0f, 0.0f)
+            .wait(1.0f)
+            .fadeOut(0.5f);
+        builder.add(Timeline::Target::Overlay, layer, 1, { .opacity = 0 })
+            .wait(0.25f)
+            .fadeIn(1.0f);
+        builder.add(Timeline::Target::Fragment, layer, 2, {})
+            .jumpTo(2.0f, 0.0f, 0.0f, 80.0f);
+        builder.add(Timeline::Target::Fragment, layer, 3, {})
+            .scaleTo(0.5f, 2.0f, Ease::Out, 2.0f)
+            .wait(0.5f)
+            .scaleTo(0.5f, 1.0f)
+            .wait(0.5f)
+            .remove();
+        return builder.build();
+    }
+
+    void checkSampling() {
+        auto timeline = fourFragments();
+        EXPECT(timeline.getFragments().size() == 4);
+        EXPECT(near(timeline.getDuration(), 2.0f));
+
+        EXPECT(near(timeline.sample(0, Timeline::X, 0.0f), 0.0f));
+        EXPECT(near(timeline.sample(0, Timeline::X, 0.5f), 50.0f));
+        EXPECT(near(timeline.sample(0, Timeline::X, 3.0f), 100.0f));
+        EXPECT(near(timeline.sample(0, Timeline::Opacity, 1.25f), 127.5f));
+        EXPECT(near(timeline.getFragments()[0].hidden, 1.5f));
+
+        EXPECT(near(timeline.sample(1, Timeline::Opacity, 0.25f), 0.0f));
+        EXPECT(near(timeline.sample(1, Timeline::Opacity, 0.75f), 127.5f));
+        EXPECT(near(timeline.getFragments()[1].start, 0.25f));
+
+        // The jump peaks at its height halfway, on top of the straight path
+        EXPECT(near(timeline.sample(2, Timeline::Y, 1.0f), 80.0f));
+        EXPECT(near(timeline.sample(2, Timeline::Y, 2.0f), 0.0f));
+
+        EXPECT(near(timeline.sample(3, Timeline::Scale, 0.25f), 1.0f + Timeline::ease(Ease::Out, 2.0f, 0.5f)));
+        EXPECT(near(Timeline::ease(Ease::Out, 2.0f, 0.25f), 0.5f));
+        EXPECT(near(Timeline::ease(Ease::InOut, 2.0f, 0.5f), 0.5f));
+        EXPECT(near(timeline.getFragments()[3].end, 1.0f));
+
+        // The forward-only cursor gives what a fresh binary search does, frame after frame
+        for (size_t fragment = 0; fragment < timeline.getFragments().size(); fragment++) {
+            for (int channel = 0; channel < Timeline::ChannelCount; channel++) {
+                uint32_t cursor = 0;
+                for (float time = 0.0f; time < 2.5f; time += 1.0f / 60.0f) {
+                    auto id = static_cast<Timeline::Channel>(channel);
+                    EXPECT(timeline.evaluate(fragment, id, time, cursor) == timeline.sample(fragment, id, time));
+                }
+            }
+        }
+    }
+
+    void checkScaling() {
+        auto original = fourFragments();
+        auto scaled = original;
+        scaled.scaleTo(5.0f);
+        EXPECT(near(scaled.getDuration(), 5.0f));
+
+        float factor = 5.0f / original.getDuration();
+        for (size_t fragment = 0; fragment < original.getFragments().size(); fragment++) {
+            auto const& before = original.getFragments()[fragment];
+            auto const& after = scaled.getFragments()[fragment];
+            EXPECT(near(after.start, before.start * factor));
+            EXPECT(near(after.settled, before.settled * factor));
+            EXPECT(before.end == after.end || near(after.end, before.end * factor));
+            for (int channel = 0; channel < Timeline::ChannelCount; channel++) {
+                auto id = static_cast<Timeline::Channel>(channel);
+                for (float time = 0.0f; time < 2.0f; time += 0.1f) {
+                    EXPECT(near(scaled.sample(fragment, id, time * factor), original.sample(fragment, id, time), 1e-3f));
+                }
+            }
+        }
+
+        // Nothing to scale, or nothing to scale to, leaves it as it is
+        Timeline empty;
+        empty.scaleTo(3.0f);
+        EXPECT(empty.getDuration() == 0.0f);
+        scaled.scaleTo(0.0f);
+        EXPECT(near(scaled.getDuration(), 5.0f));
+    }
+
+    void checkRemoval() {
+        auto original = fourFragments();
+
+        // Nothing removed: every track is copied onto itself
+        auto all = original;
+        all.removeFragments([](Timeline::Fragment const&) { return false; });
+        EXPECT(all.getFragments().size() == 4);
+        EXPECT(all.getKeyCount() == original.getKeyCount());
+
+        // The overlay goes, the fragments after it keep their own keys
+        auto fragments = original;
+        fragments.removeFragments([](Timeline::Fragment const& fragment) { return fragment.target == Timeline::Target::Overlay; });
+        EXPECT(fragments.getFragments().size() == 3);
+        EXPECT(fragments.getKeyCount() < original.getKeyCount());
+        EXPECT(near(fragments.getDuration(), original.getDuration()));
+        size_t kept[] = { 0, 2, 3 };
+        for (size_t fragment = 0; fragment < 3; fragment++) {
+            EXPECT(fragments.getFragments()[fragment].zOrder == original.getFragments()[kept[fragment]].zOrder);
+            for (int channel = 0; channel < Timeline::ChannelCount; channel++) {
+                auto id = static_cast<Timeline::Channel>(channel);
+                for (float time = 0.0f; time < 2.5f; time += 0.05f) {
+                    EXPECT(fragments.sample(fragment, id, time) == original.sample(kept[fragment], id, time));
+                }
+            }
+        }
+
+        auto none = original;
+        none.removeFragments([](Timeline::Fragment const&) { return true; });
+        EXPECT(none.getFragments().empty());
+        EXPECT(none.getKeyCount() == 0);
+    }
+}
+
+int main() {
+    checkSampling();
+    checkScaling();
+    checkRemoval();
+    if (s_failures) {
+        std::fprintf(stderr, "%d timeline checks failed\n", s_failures);
+        return 1;
+    }
+    std::printf("Timeline checks passed\n");
+    return 0;
+}
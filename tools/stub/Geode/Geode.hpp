@@ -0,0 +1,628 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Just enough of cocos2d and Geode for the tools to build mod sources that need the game: a
+// scene graph with real parents, children, enter and exit and transforms, and game classes that
+// only hold what those sources read. Nothing draws; draw() works out the quads a frame would
+// submit and counts them. Results, fmt::format and a matjson parser cover the compiler.
+
+namespace cocos2d {
+    using GLubyte = unsigned char;
+
+    struct ccColor3B {
+        GLubyte r, g, b;
+    };
+
+    inline ccColor3B ccc3(GLubyte r, GLubyte g, GLubyte b) { return { r, g, b }; }
+
+    struct CCPoint {
+        float x = 0.0f;
+        float y = 0.0f;
+
+        CCPoint() = default;
+        CCPoint(float x, float y) : x(x), y(y) {}
+
+        CCPoint operator+(CCPoint const& other) const { return { x + other.x, y + other.y }; }
+        CCPoint operator-(CCPoint const& other) const { return { x - other.x, y - other.y }; }
+        CCPoint operator*(float factor) const { return { x * factor, y * factor }; }
+    };
+
+    inline CCPoint ccp(float x, float y) { return { x, y }; }
+
+    struct CCSize {
+        float width = 0.0f;
+        float height = 0.0f;
+    };
+
+    #define CC_DEGREES_TO_RADIANS(angle) ((angle) * 0.01745329252f)
+    #define CC_RADIANS_TO_DEGREES(angle) ((angle) * 57.29577951f)
+
+    // Counted like cocos2d's, autoreleased objects live until the pool is popped
+    class CCObject {
+    public:
+        virtual ~CCObject() = default;
+
+        void retain() { m_references++; }
+        void release() {
+            if (--m_references == 0) delete this;
+        }
+        CCObject* autorelease();
+        unsigned retainCount() const { return m_references; }
+
+    private:
+        unsigned m_references = 1;
+    };
+
+    class CCPoolManager {
+    public:
+        static CCPoolManager* sharedPoolManager() {
+            static CCPoolManager manager;
+            return &manager;
+        }
+
+        void addObject(CCObject* object) { m_objects.push_back(object); }
+        void pop() {
+            auto objects = std::move(m_objects);
+            for (auto object : objects) {
+                object->release();
+            }
+        }
+
+    private:
+        std::vector<CCObject*> m_objects;
+    };
+
+    inline CCObject* CCObject::autorelease() {
+        CCPoolManager::sharedPoolManager()->addObject(this);
+        return this;
+    }
+
+    // Transforms are position, rotation and scale; anchors stay at the origin, as CCLayer's do
+    class CCNode : public CCObject {
+    public:
+        ~CCNode() override {
+            for (auto child : m_children) {
+                child->m_parent = nullptr;
+                child->release();
+            }
+        }
+
+        static CCNode* create() {
+            auto ret = new CCNode();
+            ret->init();
+            ret->autorelease();
+            return ret;
+        }
+        virtual bool init() { return true; }
+
+        virtual void setPosition(CCPoint const& position) { m_position = position; }
+        CCPoint const& getPosition() const { return m_position; }
+        float getPositionX() const { return m_position.x; }
+        float getPositionY() const { return m_position.y; }
+        virtual void setRotation(float rotation) { m_rotation = rotation; }
+        float getRotation() const { return m_rotation; }
+        virtual void setScale(float scale) { m_scaleX = m_scaleY = scale; }
+        virtual void setScaleX(float scale) { m_scaleX = scale; }
+        virtual void setScaleY(float scale) { m_scaleY = scale; }
+        float getScaleX() const { return m_scaleX; }
+        float getScaleY() const { return m_scaleY; }
+        virtual void setVisible(bool visible) { m_visible = visible; }
+        bool isVisible() const { return m_visible; }
+        void setZOrder(int zOrder) { m_zOrder = zOrder; }
+        int getZOrder() const { return m_zOrder; }
+        virtual void setContentSize(CCSize const& size) { m_contentSize = size; }
+        CCSize const& getContentSize() const { return m_contentSize; }
+        void setID(std::string_view id) { m_id = id; }
+        std::string const& getID() const { return m_id; }
+
+        virtual void addChild(CCNode* child) { addChild(child, child->m_zOrder); }
+        virtual void addChild(CCNode* child, int zOrder) {
+            child->retain();
+            child->m_parent = this;
+            child->m_zOrder = zOrder;
+            m_children.push_back(child);
+            if (m_running) child->onEnter();
+        }
+        virtual void removeChild(CCNode* child, bool) {
+            auto found = std::find(m_children.begin(), m_children.end(), child);
+            if (found == m_children.end()) return;
+            m_children.erase(found);
+            if (m_running) child->onExit();
+            child->m_parent = nullptr;
+            child->release();
+        }
+        void removeFromParentAndCleanup(bool cleanup) {
+            if (m_parent) m_parent->removeChild(this, cleanup);
+        }
+        void removeFromParent() { removeFromParentAndCleanup(true); }
+        CCNode* getParent() const { return m_parent; }
+        std::vector<CCNode*> const& getChildren() const { return m_children; }
+        size_t getChildrenCount() const { return m_children.size(); }
+
+        virtual void onEnter() {
+            m_running = true;
+            for (auto child : m_children) child->onEnter();
+        }
+        virtual void onExit() {
+            m_running = false;
+            for (auto child : m_children) child->onExit();
+        }
+        bool isRunning() const { return m_running; }
+
+        void scheduleUpdate() { m_updateScheduled = true; }
+        void unscheduleUpdate() { m_updateScheduled = false; }
+        bool isUpdateScheduled() const { return m_updateScheduled; }
+        virtual void update(float) {}
+
+        // Visits the tree the way a frame does; returns how many nodes would draw
+        size_t visit() {
+            if (!m_visible) return 0;
+            size_t drawn = draw();
+            for (auto child : m_children) drawn += child->visit();
+            return drawn;
+        }
+        virtual size_t draw() { return 0; }
+
+        CCPoint convertToWorldSpace(CCPoint const& point) const {
+            auto result = point;
+            for (auto node = this; node; node = node->m_parent) {
+                result = node->toParent(result);
+            }
+            return result;
+        }
+        CCPoint convertToNodeSpace(CCPoint const& point) const {
+            std::vector<const CCNode*> chain;
+            for (auto node = this; node; node = node->m_parent) {
+                chain.push_back(node);
+            }
+            auto result = point;
+            for (auto node = chain.rbegin(); node != chain.rend(); ++node) {
+                result = (*node)->fromParent(result);
+            }
+            return result;
+        }
+
+    private:
+    protected:
+        // Rotation is clockwise in degrees, as in cocos2d
+        CCPoint toParent(CCPoint const& point) const {
+            float angle = -CC_DEGREES_TO_RADIANS(m_rotation);
+            float x = point.x * m_scaleX;
+            float y = point.y * m_scaleY;
+            return { m_position.x + x * std::cos(angle) - y * std::sin(angle), m_position.y + x * std::sin(angle) + y * std::cos(angle) };
+        }
+        CCPoint fromParent(CCPoint const& point) const {
+            float angle = CC_DEGREES_TO_RADIANS(m_rotation);
+            float x = point.x - m_position.x;
+            float y = point.y - m_position.y;
+            return { (x * std::cos(angle) - y * std::sin(angle)) / m_scaleX, (x * std::sin(angle) + y * std::cos(angle)) / m_scaleY };
+        }
+
+    private:
+        CCNode* m_parent = nullptr;
+        std::vector<CCNode*> m_children;
+        CCPoint m_position;
+        CCSize m_contentSize;
+        float m_rotation = 0.0f;
+        float m_scaleX = 1.0f;
+        float m_scaleY = 1.0f;
+        int m_zOrder = 0;
+        bool m_visible = true;
+        bool m_running = false;
+        bool m_updateScheduled = false;
+        std::string m_id;
+    };
+
+    class CCNodeRGBA : public CCNode {
+    public:
+        virtual void setColor(ccColor3B const& color) { m_color = color; }
+        ccColor3B const& getColor() const { return m_color; }
+        virtual void setOpacity(GLubyte opacity) { m_opacity = opacity; }
+        GLubyte getOpacity() const { return m_opacity; }
+
+    protected:
+        ccColor3B m_color = { 255, 255, 255 };
+        GLubyte m_opacity = 255;
+    };
+
+    // Works out its quad on every draw, centered on its position like a batched CCSprite's
+    class CCSprite : public CCNodeRGBA {
+    public:
+        size_t draw() override {
+            if (m_opacity == 0) return 0;
+            float halfWidth = getContentSize().width / 2.0f;
+            float halfHeight = getContentSize().height / 2.0f;
+            CCPoint corners[4] = { { -halfWidth, -halfHeight }, { halfWidth, -halfHeight }, { -halfWidth, halfHeight }, { halfWidth, halfHeight } };
+            for (size_t i = 0; i < 4; i++) {
+                m_quad[i] = toParent(corners[i]);
+            }
+            m_quadColor = { static_cast<GLubyte>(m_color.r * m_opacity / 255), static_cast<GLubyte>(m_color.g * m_opacity / 255), static_cast<GLubyte>(m_color.b * m_opacity / 255) };
+            return 1;
+        }
+
+        CCPoint const* getQuad() const { return m_quad; }
+
+    private:
+        CCPoint m_quad[4];
+        ccColor3B m_quadColor = { 255, 255, 255 };
+    };
+
+    class CCLayer : public CCNode {
+    public:
+        static CCLayer* create() {
+            auto ret = new CCLayer();
+            ret->init();
+            ret->autorelease();
+            return ret;
+        }
+    };
+}
+
+// The game's classes, holding only what the mod sources built into the tools read
+
+enum class IconType { Cube, Ship, Ball, Ufo, Wave, Robot, Spider, Swing, Jetpack };
+
+class SimplePlayer : public cocos2d::CCSprite {
+public:
+    static SimplePlayer* create(int frame) {
+        auto ret = new SimplePlayer();
+        ret->updatePlayerFrame(frame, IconType::Cube);
+        ret->autorelease();
+        return ret;
+    }
+
+    void updatePlayerFrame(int frame, IconType type) {
+        m_frame = frame;
+        m_type = type;
+    }
+    void setSecondColor(cocos2d::ccColor3B const& color) { m_secondColor = color; }
+    IconType getIconType() const { return m_type; }
+
+private:
+    int m_frame = 1;
+    IconType m_type = IconType::Cube;
+    cocos2d::ccColor3B m_secondColor = { 255, 255, 255 };
+};
+
+class GameManager : public cocos2d::CCNode {
+public:
+    static GameManager* get() {
+        static GameManager manager;
+        return &manager;
+    }
+
+    int activeIconForType(IconType) { return 1; }
+    int getPlayerColor() { return 0; }
+    int getPlayerColor2() { return 3; }
+    cocos2d::ccColor3B colorForIdx(int index) { return cocos2d::ccc3(static_cast<cocos2d::GLubyte>(index * 40), 255, 0); }
+};
+
+class PlayerObject : public cocos2d::CCSprite {
+public:
+    bool m_isShip = false;
+    bool m_isBall = false;
+    bool m_isBird = false;
+    bool m_isDart = false;
+    bool m_isRobot = false;
+    bool m_isSpider = false;
+    bool m_isSwing = false;
+    bool m_isUpsideDown = false;
+    bool m_isDead = false;
+};
+
+class PlayLayer : public cocos2d::CCLayer {
+public:
+    cocos2d::CCLayer* m_objectLayer = nullptr;
+    bool m_isPaused = false;
+};
+
+namespace fmt {
+    // Plain {} placeholders only, which is all the sources built here use
+    inline void formatInto(std::ostringstream& out, std::string_view format) { out << format; }
+
+    template <class T, class... Args>
+    void formatInto(std::ostringstream& out, std::string_view format, T&& value, Args&&... args) {
+        auto placeholder = format.find("{}");
+        if (placeholder == std::string_view::npos) {
+            out << format;
+            return;
+        }
+        out << format.substr(0, placeholder) << value;
+        formatInto(out, format.substr(placeholder + 2), std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    std::string format(std::string_view format, Args&&... args) {
+        std::ostringstream out;
+        formatInto(out, format, std::forward<Args>(args)...);
+        return out.str();
+    }
+}
+
+namespace geode {
+    namespace impl {
+        template <class T>
+        struct Success {
+            T value;
+        };
+        template <>
+        struct Success<void> {};
+
+        template <class E>
+        struct Failure {
+            E error;
+        };
+    }
+
+    template <class T>
+    impl::Success<std::decay_t<T>> Ok(T&& value) { return { std::forward<T>(value) }; }
+    inline impl::Success<void> Ok() { return {}; }
+    template <class E>
+    impl::Failure<std::decay_t<E>> Err(E&& error) { return { std::forward<E>(error) }; }
+
+    template <class T = void, class E = std::string>
+    class Result {
+    public:
+        template <class U>
+        Result(impl::Success<U> success) : m_value(std::in_place_index<0>, std::move(success.value)) {}
+        template <class F>
+        Result(impl::Failure<F> failure) : m_value(std::in_place_index<1>, std::move(failure.error)) {}
+
+        bool isOk() const { return m_value.index() == 0; }
+        bool isErr() const { return !isOk(); }
+        explicit operator bool() const { return isOk(); }
+
+        T unwrap() const { return std::get<0>(m_value); }
+        template <class U>
+        T unwrapOr(U&& fallback) const { return isOk() ? std::get<0>(m_value) : T(std::forward<U>(fallback)); }
+        E unwrapErr() const { return std::get<1>(m_value); }
+
+    private:
+        std::variant<T, E> m_value;
+    };
+
+    template <class E>
+    class Result<void, E> {
+    public:
+        Result(impl::Success<void>) {}
+        template <class F>
+        Result(impl::Failure<F> failure) : m_error(std::move(failure.error)) {}
+
+        bool isOk() const { return !m_error; }
+        bool isErr() const { return !isOk(); }
+        explicit operator bool() const { return isOk(); }
+
+        E unwrapErr() const { return *m_error; }
+
+    private:
+        std::optional<E> m_error;
+    };
+
+    #define GEODE_STUB_CONCAT2(a, b) a##b
+    #define GEODE_STUB_CONCAT(a, b) GEODE_STUB_CONCAT2(a, b)
+    #define GEODE_UNWRAP(expression) \
+        do { \
+            auto result = (expression); \
+            if (!result) return geode::Err(result.unwrapErr()); \
+        } while (false)
+    #define GEODE_UNWRAP_INTO(variable, expression) \
+        auto GEODE_STUB_CONCAT(unwrapped, __LINE__) = (expression); \
+        if (!GEODE_STUB_CONCAT(unwrapped, __LINE__)) return geode::Err(GEODE_STUB_CONCAT(unwrapped, __LINE__).unwrapErr()); \
+        variable = GEODE_STUB_CONCAT(unwrapped, __LINE__).unwrap()
+
+    // Node IDs are prefixed with the mod ID in the game; nothing here looks them up
+    inline std::string operator""_spr(const char* id, size_t size) { return std::string(id, size); }
+
+    namespace prelude {
+        using namespace cocos2d;
+        using namespace geode;
+    }
+}
+
+namespace matjson {
+    struct ParseError {
+        std::string message;
+    };
+
+    // Objects keep their members in order, each knowing its key, as matjson's iteration gives them
+    class Value {
+    public:
+        enum class Kind { Null, Bool, Number, String, Array, Object };
+
+        bool isNull() const { return m_kind == Kind::Null; }
+        bool isBool() const { return m_kind == Kind::Bool; }
+        bool isNumber() const { return m_kind == Kind::Number; }
+        bool isString() const { return m_kind == Kind::String; }
+        bool isArray() const { return m_kind == Kind::Array; }
+        bool isObject() const { return m_kind == Kind::Object; }
+
+        geode::Result<bool> asBool() const {
+            if (!isBool()) return geode::Err("not a bool");
+            return geode::Ok(m_bool);
+        }
+        geode::Result<double> asDouble() const {
+            if (!isNumber()) return geode::Err("not a number");
+            return geode::Ok(m_number);
+        }
+        geode::Result<std::string> asString() const {
+            if (!isString()) return geode::Err("not a string");
+            return geode::Ok(m_string);
+        }
+        std::optional<std::string> getKey() const { return m_key; }
+
+        size_t size() const { return m_items.size(); }
+        bool contains(std::string_view key) const {
+            return isObject() && std::any_of(m_items.begin(), m_items.end(), [&](Value const& item) { return item.m_key == key; });
+        }
+        Value const& operator[](std::string_view key) const {
+            static const Value null;
+            if (!isObject()) return null;
+            auto found = std::find_if(m_items.begin(), m_items.end(), [&](Value const& item) { return item.m_key == key; });
+            return found == m_items.end() ? null : *found;
+        }
+        Value const& operator[](size_t index) const { return m_items[index]; }
+        std::vector<Value>::const_iterator begin() const { return m_items.begin(); }
+        std::vector<Value>::const_iterator end() const { return m_items.end(); }
+
+        std::string dump(int = 4) const {
+            std::ostringstream out;
+            switch (m_kind) {
+                case Kind::Null: out << "null"; break;
+                case Kind::Bool: out << (m_bool ? "true" : "false"); break;
+                case Kind::Number: out << m_number; break;
+                case Kind::String: out << '"' << m_string << '"'; break;
+                case Kind::Array:
+                case Kind::Object:
+                    out << (isArray() ? '[' : '{');
+                    for (size_t i = 0; i < m_items.size(); i++) {
+                        if (i) out << ',';
+                        if (isObject()) out << '"' << *m_items[i].m_key << "\":";
+                        out << m_items[i].dump(0);
+                    }
+                    out << (isArray() ? ']' : '}');
+                    break;
+            }
+            return out.str();
+        }
+
+    private:
+        friend class Parser;
+
+        Kind m_kind = Kind::Null;
+        bool m_bool = false;
+        double m_number = 0.0;
+        std::string m_string;
+        std::vector<Value> m_items;
+        std::optional<std::string> m_key;
+    };
+
+    class Parser {
+    public:
+        explicit Parser(std::string_view text) : m_text(text) {}
+
+        std::optional<Value> document() {
+            auto value = parseValue();
+            skipSpace();
+            if (value && m_at != m_text.size()) return fail("trailing characters");
+            return value;
+        }
+        std::string const& getError() const { return m_error; }
+
+    private:
+        std::nullopt_t fail(const char* what) {
+            if (m_error.empty()) m_error = fmt::format("{} at offset {}", what, m_at);
+            return std::nullopt;
+        }
+
+        void skipSpace() {
+            while (m_at < m_text.size() && std::string_view(" \t\r\n").find(m_text[m_at]) != std::string_view::npos) m_at++;
+        }
+
+        bool consume(std::string_view token) {
+            if (m_text.substr(m_at, token.size()) != token) return false;
+            m_at += token.size();
+            return true;
+        }
+
+        std::optional<std::string> parseString() {
+            if (!consume("\"")) return fail("expected a string");
+            std::string result;
+            while (m_at < m_text.size() && m_text[m_at] != '"') {
+                char c = m_text[m_at++];
+                if (c == '\\' && m_at < m_text.size()) {
+                    char escaped = m_text[m_at++];
+                    switch (escaped) {
+                        case 'n': c = '\n'; break;
+                        case 't': c = '\t'; break;
+                        case 'r': c = '\r'; break;
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        case 'u':
+                            // Definitions are ASCII; anything else becomes a placeholder
+                            m_at = std::min(m_at + 4, m_text.size());
+                            c = '?';
+                            break;
+                        default: c = escaped; break;
+                    }
+                }
+                result += c;
+            }
+            if (!consume("\"")) return fail("unterminated string");
+            return result;
+        }
+
+        std::optional<Value> parseValue() {
+            skipSpace();
+            if (m_at >= m_text.size()) return fail("unexpected end");
+            Value value;
+            char c = m_text[m_at];
+            if (c == '{' || c == '[') {
+                bool object = c == '{';
+                value.m_kind = object ? Value::Kind::Object : Value::Kind::Array;
+                m_at++;
+                skipSpace();
+                if (consume(object ? "}" : "]")) return value;
+                while (true) {
+                    std::optional<std::string> key;
+                    if (object) {
+                        skipSpace();
+                        key = parseString();
+                        skipSpace();
+                        if (!key || !consume(":")) return fail("expected a key and ':'");
+                    }
+                    auto item = parseValue();
+                    if (!item) return std::nullopt;
+                    item->m_key = std::move(key);
+                    value.m_items.push_back(std::move(*item));
+                    skipSpace();
+                    if (consume(",")) continue;
+                    if (consume(object ? "}" : "]")) return value;
+                    return fail(object ? "expected ',' or '}'" : "expected ',' or ']'");
+                }
+            }
+            if (c == '"') {
+                auto string = parseString();
+                if (!string) return std::nullopt;
+                value.m_kind = Value::Kind::String;
+                value.m_string = std::move(*string);
+                return value;
+            }
+            if (consume("true") || consume("false")) {
+                value.m_kind = Value::Kind::Bool;
+                value.m_bool = c == 't';
+                return value;
+            }
+            if (consume("null")) return value;
+
+            std::string number(m_text.substr(m_at, std::min<size_t>(64, m_text.size() - m_at)));
+            char* end = nullptr;
+            value.m_number = std::strtod(number.c_str(), &end);
+            if (end == number.c_str()) return fail("unexpected character");
+            value.m_kind = Value::Kind::Number;
+            m_at += end - number.c_str();
+            return value;
+        }
+
+        std::string_view m_text;
+        size_t m_at = 0;
+        std::string m_error;
+    };
+
+    inline geode::Result<Value, ParseError> parse(std::string_view text) {
+        Parser parser(text);
+        auto value = parser.document();
+        if (!value) return geode::Err(ParseError { parser.getError() });
+        return geode::Ok(std::move(*value));
+    }
+}